@@ -0,0 +1,185 @@
+// ------------------
+// AlignedAllocator.h
+// ------------------
+
+#ifndef AlignedAllocator_h
+#define AlignedAllocator_h
+
+#include <cassert>  // assert
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdlib>  // free, posix_memalign
+#include <map>      // map
+#include <mutex>    // lock_guard, mutex
+#include <new>      // bad_alloc, new
+#include <vector>   // vector
+
+#include <sys/mman.h> // madvise, mmap
+
+///
+/// How an Aligned_Allocator backs its memory
+/// small_pages - the default pages of the system
+/// transparent_huge_pages - 2 MB slabs advised with MADV_HUGEPAGE
+/// explicit_huge_pages - 2 MB slabs mapped with MAP_HUGETLB, falling back to transparent huge pages when none are reserved
+///
+enum Page_Policy { small_pages, transparent_huge_pages, explicit_huge_pages };
+
+///
+/// An allocator whose blocks start on an Align byte boundary, such as a cache line, and optionally live on huge pages
+/// With huge pages, blocks smaller than a slab are carved out of shared 2 MB slabs, and freed blocks are kept for reuse by size;
+/// the slabs are never returned to the system.
+/// @tparam T - Type of the elements
+/// @tparam Align - the alignment of every block, a power of two that is at least alignof(T)
+/// @tparam P - the Page_Policy
+///
+template <typename T, std::size_t Align = 64, Page_Policy P = small_pages>
+struct Aligned_Allocator
+{
+    static_assert((Align & (Align - 1)) == 0 && Align >= alignof(T), "Align must be a power of two that is at least alignof(T)");
+
+    typedef T                 value_type;
+
+    typedef std::size_t       size_type;
+    typedef std::ptrdiff_t    difference_type;
+
+    typedef value_type*       pointer;
+    typedef const value_type* const_pointer;
+
+    typedef value_type&       reference;
+    typedef const value_type& const_reference;
+
+    static const size_type slab_size = 2 * 1024 * 1024;
+
+    friend bool operator == (const Aligned_Allocator&, const Aligned_Allocator&)
+    {
+        return true;
+    }
+
+    friend bool operator != (const Aligned_Allocator&, const Aligned_Allocator&)
+    {
+        return false;
+    }
+
+    Aligned_Allocator ()
+    {}
+
+    template <typename U>
+    Aligned_Allocator (const Aligned_Allocator<U, Align, P>&)
+    {}
+
+    // Default copy, destructor, and copy assignment
+    // Aligned_Allocator  (const Aligned_Allocator&);
+    // ~Aligned_Allocator ();
+    // Aligned_Allocator& operator = (const Aligned_Allocator&);
+
+    pointer allocate (size_type n)
+    {
+        size_type bytes = round_up(n * sizeof(value_type));
+        if (P == small_pages || bytes > slab_size)
+            return static_cast<pointer>(aligned(bytes, (P == small_pages) ? Align : slab_size));
+        pool& x = shared();
+        std::lock_guard<std::mutex> lock(x.m);
+        std::vector<char*>& f = x.free[bytes];
+        if (!f.empty())
+        {
+            char* p = f.back();
+            f.pop_back();
+            return reinterpret_cast<pointer>(p);
+        }
+        if (x.left < bytes)
+        {
+            x.slab = slab();
+            x.left = slab_size;
+        }
+        char* p = x.slab;
+        x.slab += bytes;
+        x.left -= bytes;
+        return reinterpret_cast<pointer>(p);
+    }
+
+    void construct (pointer p, const_reference v)
+    {
+        new (p) value_type(v);
+    }
+
+    void deallocate (pointer p, size_type n)
+    {
+        assert(p);
+        size_type bytes = round_up(n * sizeof(value_type));
+        if (P == small_pages || bytes > slab_size)
+        {
+            std::free(p);
+            return;
+        }
+        pool& x = shared();
+        std::lock_guard<std::mutex> lock(x.m);
+        x.free[bytes].push_back(reinterpret_cast<char*>(p));
+    }
+
+    void destroy (pointer p)
+    {
+        p->~value_type();
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        typedef Aligned_Allocator<U, Align, P> other;
+    };
+
+private:
+    ///
+    /// The slab and the freed blocks shared by every Aligned_Allocator of the same type
+    ///
+    struct pool
+    {
+        std::mutex m;
+        char* slab;
+        size_type left;
+        std::map<size_type, std::vector<char*> > free;
+
+        pool () : slab (nullptr), left (0)
+        {}
+    };
+
+    static pool& shared ()
+    {
+        static pool x;
+        return x;
+    }
+
+    static size_type round_up (size_type bytes)
+    {
+        return (bytes + Align - 1) / Align * Align;
+    }
+
+    ///
+    /// @param bytes - the size of the block
+    /// @param align - the alignment of the block
+    /// @return a block from posix_memalign, advised to use huge pages unless the Page_Policy is small_pages
+    ///
+    static void* aligned (size_type bytes, size_type align)
+    {
+        void* p = nullptr;
+        if (posix_memalign(&p, align, bytes) != 0)
+            throw std::bad_alloc();
+        if (P != small_pages)
+            madvise(p, bytes, MADV_HUGEPAGE);
+        return p;
+    }
+
+    ///
+    /// @return a new 2 MB slab
+    ///
+    static char* slab ()
+    {
+        if (P == explicit_huge_pages)
+        {
+            void* p = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+                return static_cast<char*>(p);
+        }
+        return static_cast<char*>(aligned(slab_size, slab_size));
+    }
+};
+
+#endif // AlignedAllocator_h
@@ -0,0 +1,107 @@
+// --------------
+// BenchDeque.c++
+// --------------
+
+/*
+   To run the benchmarks:
+   % g++ -pedantic -std=c++0x -Wall -O3 BenchDeque.c++ -o BenchDeque -lpthread
+   % ./BenchDeque [size]
+ */
+
+// --------
+// includes
+// --------
+
+#include <chrono>    // steady_clock
+#include <cstdlib>   // atol
+#include <iostream>  // cout, endl
+#include <string>    // string
+
+#include "AlignedAllocator.h"
+#include "Deque.h"
+#include "Simd.h"
+
+// -------
+// seconds
+// -------
+
+///
+/// @tparam F - a function object
+/// @param f - the work to time
+/// @return the wall time of f in seconds
+///
+template <typename F>
+double seconds (F f)
+{
+	std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+// -----
+// bench
+// -----
+
+///
+/// Print the throughput of a full scan with iterators, a full scan by segments, a SIMD count, and random access over a MyDeque
+/// @tparam D - a MyDeque type
+/// @param name - the name of the row
+/// @param n - the number of elements
+///
+template <typename D>
+void bench (const std::string& name, std::size_t n)
+{
+	D x;
+	for(std::size_t i = 0; i < n; ++i)
+		x.push_back(static_cast<typename D::value_type>(i));
+
+	volatile long long sink = 0;
+	double scan = seconds([&] ()
+	{
+		long long s = 0;
+		for(typename D::const_iterator i = x.begin(); i != x.end(); ++i)
+			s += *i;
+		sink = s;
+	});
+	double segment = seconds([&] ()
+	{
+		long long s = 0;
+		x.for_each_segment(0, x.size(), [&s] (const typename D::value_type* b, const typename D::value_type* e)
+		{
+			while(b != e)
+				s += *b++;
+		});
+		sink = s;
+	});
+	double count = seconds([&] ()
+	{
+		sink = simd::count(x, static_cast<typename D::value_type>(n / 2));
+	});
+	double random = seconds([&] ()
+	{
+		long long s = 0;
+		std::size_t k = 12345;
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			k = (k * 6364136223846793005ULL + 1442695040888963407ULL);
+			s += x[(k >> 17) % n];
+		}
+		sink = s;
+	});
+	(void) sink;
+	std::cout << name << "\tscan " << n / scan / 1e6 << " M/s\tsegment " << n / segment / 1e6 << " M/s\tcount " << n / count / 1e6 << " M/s\trandom " << n / random / 1e6 << " M/s" << std::endl;
+}
+
+// ----
+// main
+// ----
+
+int main (int argc, char* argv[])
+{
+	std::size_t n = (argc > 1) ? std::atol(argv[1]) : 20000000;
+	bench< MyDeque<int> >("std::allocator", n);
+	bench< MyDeque<int, Aligned_Allocator<int, 64> > >("aligned 64", n);
+	bench< MyDeque<int, Aligned_Allocator<int, 64, transparent_huge_pages> > >("transparent huge", n);
+	bench< MyDeque<int, Aligned_Allocator<int, 64, explicit_huge_pages> > >("explicit huge", n);
+	return 0;
+}
@@ -0,0 +1,497 @@
+// ---------
+// Channel.h
+// ---------
+
+#ifndef Channel_h
+#define Channel_h
+
+// The channel needs C++20 coroutines; in earlier modes this header declares nothing
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // min
+#include <coroutine> // coroutine_handle
+#include <cstddef>   // size_t
+#include <iterator>  // back_inserter
+#include <memory>    // allocator
+#include <mutex>     // lock_guard, mutex, unique_lock
+#include <optional>  // optional
+#include <utility>   // move
+#include <vector>    // vector
+
+#include "Deque.h" // MyDeque
+
+// -------------
+// LocalExecutor
+// -------------
+
+///
+/// An executor that resumes the coroutines posted to it on the thread that calls run, in the order they were posted
+/// It is not thread safe, so every coroutine that uses it must run on that thread.
+///
+class LocalExecutor
+{
+private:
+	MyDeque<std::coroutine_handle<> > ready;
+
+public:
+	/**
+	* @param h - a suspended coroutine to resume from run
+	*/
+	void post (std::coroutine_handle<> h)
+	{
+		ready.push_back(h);
+	}
+
+	/**
+	* Resume posted coroutines until none is left, including the ones they post
+	* @return the # of coroutines resumed
+	*/
+	std::size_t run ()
+	{
+		std::size_t n = 0;
+		while(!ready.empty())
+		{
+			std::coroutine_handle<> h = ready.front();
+			ready.pop_front();
+			h.resume();
+			++n;
+		}
+		return n;
+	}
+};
+
+// -------
+// Channel
+// -------
+
+///
+/// A bounded queue between coroutines, stored in a MyDeque, whose push and pop suspend the calling coroutine instead of blocking
+/// its thread
+/// co_await push(v) suspends while the channel is full and co_await pop() suspends while it is empty; a push that finds a
+/// suspended pop hands its element over directly. The coroutines an operation wakes are collected under the lock and posted
+/// to the executor together after it is released, and pop_n takes a batch of elements and wakes a batch of pushes at once.
+/// Any thread may use a Channel; the executor decides where the woken coroutines run.
+/// @tparam T - Type of the elements
+/// @tparam E - Type of the executor, which has a member function post(std::coroutine_handle<>)
+/// @tparam A - Type of Allocator object of the MyDeque; The default value - std::allocator
+///
+template <typename T, typename E = LocalExecutor, typename A = std::allocator<T> >
+class Channel
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef T           value_type;
+	typedef std::size_t size_type;
+
+private:
+	///
+	/// A push suspended while the channel is full, whose element lives in its awaiter
+	///
+	struct pusher
+	{
+		std::coroutine_handle<> h;
+		T* v;
+		bool* ok;
+	};
+
+	///
+	/// A pop or pop_n suspended while the channel is empty, whose result lives in its awaiter
+	///
+	struct popper
+	{
+		std::coroutine_handle<> h;
+		std::optional<T>* one;
+		std::vector<T>* many;
+	};
+
+	typedef std::vector<std::coroutine_handle<> > wakeups;
+
+	// ----
+	// data
+	// ----
+
+	E& ex;
+	std::mutex m;
+	MyDeque<T, A> buffer;
+	size_type cap;
+	MyDeque<pusher> pushers;
+	MyDeque<popper> poppers;
+	bool closed;
+
+private:
+	///
+	/// Post the coroutines an operation woke, after it released the lock
+	/// @param w - the coroutines
+	///
+	void wake (const wakeups& w)
+	{
+		for(size_type i = 0; i != w.size(); ++i)
+			ex.post(w[i]);
+	}
+
+	///
+	/// Move suspended pushes into the buffer while it has room; the lock must be held
+	/// @param w - the coroutines to wake
+	///
+	void refill (wakeups& w)
+	{
+		while(!pushers.empty() && buffer.size() < cap)
+		{
+			pusher x = pushers.front();
+			pushers.pop_front();
+			buffer.push_back(std::move(*x.v));
+			*x.ok = true;
+			w.push_back(x.h);
+		}
+	}
+
+	///
+	/// Push an element unless the channel is full or closed; the lock must be held
+	/// @param v - the element
+	/// @param w - the coroutines to wake
+	/// @return true if the element was pushed or handed to a suspended pop
+	///
+	bool push_locked (T& v, wakeups& w)
+	{
+		if(closed)
+			return false;
+		if(!poppers.empty())
+		{
+			popper x = poppers.front();
+			poppers.pop_front();
+			if(x.many != nullptr)
+				x.many->push_back(std::move(v));
+			else
+				x.one->emplace(std::move(v));
+			w.push_back(x.h);
+			return true;
+		}
+		if(buffer.size() == cap)
+			return false;
+		buffer.push_back(std::move(v));
+		return true;
+	}
+
+	///
+	/// Pop an element unless the channel is empty; the lock must be held
+	/// @param v - the element
+	/// @param w - the coroutines to wake
+	/// @return true if an element was popped
+	///
+	bool pop_locked (std::optional<T>& v, wakeups& w)
+	{
+		if(!buffer.empty())
+		{
+			v.emplace(std::move(buffer.front()));
+			buffer.pop_front();
+		}
+		else if(!pushers.empty())
+		{
+			// A channel of capacity 0 takes the element straight from a suspended push
+			pusher x = pushers.front();
+			pushers.pop_front();
+			v.emplace(std::move(*x.v));
+			*x.ok = true;
+			w.push_back(x.h);
+		}
+		refill(w);
+		return v.has_value();
+	}
+
+	///
+	/// Pop up to n elements unless the channel is empty; the lock must be held
+	/// @param n - the most elements to pop
+	/// @param out - a vector the elements are appended to
+	/// @param w - the coroutines to wake
+	/// @return true if an element was popped
+	///
+	bool pop_n_locked (size_type n, std::vector<T>& out, wakeups& w)
+	{
+		size_type k = std::min<size_type>(n, buffer.size());
+		buffer.pop_front_n(k, std::back_inserter(out));
+		// A channel of capacity 0, or a batch larger than the buffer, takes elements straight from suspended pushes
+		while(k < n && !pushers.empty())
+		{
+			pusher x = pushers.front();
+			pushers.pop_front();
+			out.push_back(std::move(*x.v));
+			*x.ok = true;
+			w.push_back(x.h);
+			++k;
+		}
+		refill(w);
+		return k != 0;
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty Channel
+	* @param c - the # of elements the channel holds before push suspends; with 0, push waits for a pop
+	* @param e - the executor that resumes woken coroutines, which must outlive the channel
+	*/
+	Channel (size_type c, E& e) : ex (e), cap (c), closed (false)
+	{}
+
+	Channel (const Channel&) = delete;
+	Channel& operator = (const Channel&) = delete;
+
+	// -----
+	// close
+	// -----
+
+	/**
+	* Close the channel: suspended and later pushes fail, and pops fail once the buffer is empty
+	*/
+	void close ()
+	{
+		wakeups w;
+		{
+			std::lock_guard<std::mutex> lock(m);
+			closed = true;
+			for(; !pushers.empty(); pushers.pop_front())
+			{
+				*pushers.front().ok = false;
+				w.push_back(pushers.front().h);
+			}
+			for(; !poppers.empty(); poppers.pop_front())
+				w.push_back(poppers.front().h);
+		}
+		wake(w);
+	}
+
+	// ---
+	// pop
+	// ---
+
+	///
+	/// The awaiter of pop
+	///
+	class pop_awaiter
+	{
+		friend class Channel;
+
+	private:
+		Channel& c;
+		std::optional<T> v;
+
+		explicit pop_awaiter (Channel& x) : c (x)
+		{}
+
+	public:
+		bool await_ready () const noexcept
+		{
+			return false;
+		}
+
+		bool await_suspend (std::coroutine_handle<> h)
+		{
+			wakeups w;
+			std::unique_lock<std::mutex> lock(c.m);
+			if(!c.pop_locked(v, w) && !c.closed)
+			{
+				// Another thread may resume the coroutine as soon as the lock is released, so the awaiter is not touched after that
+				c.poppers.push_back(popper {h, &v, nullptr});
+				return true;
+			}
+			lock.unlock();
+			c.wake(w);
+			return false;
+		}
+
+		/**
+		* @return the element, or nothing if the channel was closed and empty
+		*/
+		std::optional<T> await_resume ()
+		{
+			return std::move(v);
+		}
+	};
+
+	/**
+	* @return an awaiter that suspends until the channel has an element or is closed, and yields the element or nothing
+	*/
+	pop_awaiter pop ()
+	{
+		return pop_awaiter(*this);
+	}
+
+	///
+	/// The awaiter of pop_n
+	///
+	class pop_n_awaiter
+	{
+		friend class Channel;
+
+	private:
+		Channel& c;
+		size_type n;
+		std::vector<T> v;
+
+		pop_n_awaiter (Channel& x, size_type k) : c (x), n (k)
+		{}
+
+	public:
+		bool await_ready () const noexcept
+		{
+			return false;
+		}
+
+		bool await_suspend (std::coroutine_handle<> h)
+		{
+			wakeups w;
+			std::unique_lock<std::mutex> lock(c.m);
+			if(!c.pop_n_locked(n, v, w) && !c.closed)
+			{
+				c.poppers.push_back(popper {h, nullptr, &v});
+				return true;
+			}
+			lock.unlock();
+			c.wake(w);
+			return false;
+		}
+
+		/**
+		* @return the elements, which are empty only if the channel was closed and empty
+		*/
+		std::vector<T> await_resume ()
+		{
+			return std::move(v);
+		}
+	};
+
+	/**
+	* @param n - the most elements to pop, at least 1
+	* @return an awaiter that suspends until the channel has an element or is closed, and yields up to n elements
+	*/
+	pop_n_awaiter pop_n (size_type n)
+	{
+		return pop_n_awaiter(*this, n);
+	}
+
+	// ----
+	// push
+	// ----
+
+	///
+	/// The awaiter of push
+	///
+	class push_awaiter
+	{
+		friend class Channel;
+
+	private:
+		Channel& c;
+		T v;
+		bool ok;
+
+		push_awaiter (Channel& x, T y) : c (x), v (std::move(y)), ok (false)
+		{}
+
+	public:
+		bool await_ready () const noexcept
+		{
+			return false;
+		}
+
+		bool await_suspend (std::coroutine_handle<> h)
+		{
+			wakeups w;
+			std::unique_lock<std::mutex> lock(c.m);
+			ok = c.push_locked(v, w);
+			if(!ok && !c.closed)
+			{
+				c.pushers.push_back(pusher {h, &v, &ok});
+				return true;
+			}
+			lock.unlock();
+			c.wake(w);
+			return false;
+		}
+
+		/**
+		* @return true if the element was pushed, false if the channel was closed
+		*/
+		bool await_resume () const noexcept
+		{
+			return ok;
+		}
+	};
+
+	/**
+	* @param v - the element
+	* @return an awaiter that suspends while the channel is full, and yields false if the channel was closed
+	*/
+	push_awaiter push (T v)
+	{
+		return push_awaiter(*this, std::move(v));
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the # of elements in the buffer
+	*/
+	size_type size ()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		return buffer.size();
+	}
+
+	// --------
+	// try_push
+	// --------
+
+	/**
+	* Push an element without suspending
+	* @param v - the element
+	* @return false if the channel is full or closed
+	*/
+	bool try_push (T v)
+	{
+		wakeups w;
+		bool ok;
+		{
+			std::lock_guard<std::mutex> lock(m);
+			ok = push_locked(v, w);
+		}
+		wake(w);
+		return ok;
+	}
+
+	// -------
+	// try_pop
+	// -------
+
+	/**
+	* Pop an element without suspending
+	* @return the element, or nothing if the channel is empty
+	*/
+	std::optional<T> try_pop ()
+	{
+		wakeups w;
+		std::optional<T> v;
+		{
+			std::lock_guard<std::mutex> lock(m);
+			pop_locked(v, w);
+		}
+		wake(w);
+		return v;
+	}
+};
+
+#endif // __cpp_impl_coroutine
+
+#endif // Channel_h
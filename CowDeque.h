@@ -0,0 +1,638 @@
+// ----------
+// CowDeque.h
+// ----------
+
+#ifndef CowDeque_h
+#define CowDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // equal, lexicographical_compare, max, min, swap
+#include <cassert>   // assert
+#include <cstddef>   // ptrdiff_t, size_t
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // out_of_range
+#include <vector>    // vector
+
+#include "Deque.h"    // SIZET, USIZET, destroy, uninitialized_copy, uninitialized_fill
+#include "Iterator.h" // IndexIterator
+
+// --------
+// CowDeque
+// --------
+
+///
+/// A deque whose copies share inner arrays until one of them modifies an inner array
+/// Each inner array has a reference count. Copying a CowDeque copies the outer array and increments the counts, so a snapshot
+/// costs O(blocks). Before a CowDeque constructs, destroys or hands out a modifiable reference to an element, it clones the
+/// inner array holding it if the inner array is shared, so only the inner arrays a copy modifies are ever duplicated.
+/// The reference counts are atomic, so a copy may be destroyed on another thread; reading the same CowDeque from several threads
+/// while it is modified still needs a lock.
+/// Non-const operator [], at, front, back and iterators count as modifications, as in any copy-on-write container.
+/// @tparam T - Type of the elements
+/// @tparam A - Type of Allocator object used to define the storage allocation model; The default value - std::allocator
+///
+template < typename T, typename A = std::allocator<T> >
+class CowDeque
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef A                                                  allocator_type;
+	typedef typename std::allocator_traits<A>::value_type      value_type;
+
+	typedef typename std::allocator_traits<A>::size_type       size_type;
+	typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+	typedef typename std::allocator_traits<A>::pointer         pointer;
+	typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
+
+	typedef value_type&                                        reference;
+	typedef const value_type&                                  const_reference;
+
+	typedef IndexIterator<CowDeque, value_type, reference, pointer>                   iterator;
+	typedef IndexIterator<const CowDeque, value_type, const_reference, const_pointer> const_iterator;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side CowDeque
+	* @param rhs - the right hand side CowDeque
+	* @return true if the lhs CowDeque is equal to the rhs CowDeque
+	*/
+	friend bool operator == (const CowDeque& lhs, const CowDeque& rhs)
+	{
+		return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side CowDeque
+	* @param rhs - the right hand side CowDeque
+	* @return true if the lhs CowDeque is lexicographically less than the rhs CowDeque
+	*/
+	friend bool operator < (const CowDeque& lhs, const CowDeque& rhs)
+	{
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+private:
+	///
+	/// An inner array and the # of CowDeque containers that share it
+	///
+	struct chunk
+	{
+		std::size_t refs;
+		pointer p;
+	};
+
+	typedef typename std::allocator_traits<A>::template rebind_alloc<chunk> chunk_allocator;
+
+	// ----
+	// data
+	// ----
+
+	allocator_type _a;
+	chunk_allocator _ca;
+	std::vector<chunk*> map; // the circular outer array, where an inner array that was never used is nullptr
+	size_type head;          // the slot of the first inner array
+	size_type b;             // the offset of the first element in the first inner array
+	size_type count;         // the # of elements
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the CowDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		if(map.empty())
+			return head == 0 && b == 0 && count == 0;
+		return (head < map.size()) && (b < USIZET) && (b + count <= map.size() * USIZET);
+	}
+
+	///
+	/// Find an inner array of the circular outer array
+	/// @param k - the number of inner arrays after the first inner array
+	/// @return the outer array slot of the inner array
+	///
+	chunk*& slot (size_type k)
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	chunk* slot (size_type k) const
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	///
+	/// The elements of an inner array are at the offsets [lo(k), hi(k)), which is empty for an unused inner array
+	/// @param k - the number of inner arrays after the first inner array
+	///
+	size_type lo (size_type k) const
+	{
+		return (k == 0) ? b : 0;
+	}
+
+	size_type hi (size_type k) const
+	{
+		return std::max<size_type>(lo(k), std::min<size_type>(SIZET, (b + count > k * SIZET) ? b + count - k * SIZET : 0));
+	}
+
+	///
+	/// Give up a reference to an inner array, and destroy its elements and free it if it was the last one
+	/// @param c - the inner array, or nullptr
+	/// @param i - the offset of its first element
+	/// @param j - the offset past its last element
+	///
+	void release (chunk* c, size_type i, size_type j)
+	{
+		if(c == nullptr || __atomic_sub_fetch(&c->refs, 1, __ATOMIC_ACQ_REL) != 0)
+			return;
+		destroy(_a, c->p + i, c->p + j);
+		_a.deallocate(c->p, SIZET);
+		_ca.deallocate(c, 1);
+	}
+
+	///
+	/// Make an inner array safe to modify, allocating it if it was never used and cloning it if it is shared
+	/// @param k - the number of inner arrays after the first inner array
+	/// @return the inner array
+	///
+	pointer writable (size_type k)
+	{
+		chunk*& c = slot(k);
+		if(c != nullptr && __atomic_load_n(&c->refs, __ATOMIC_ACQUIRE) == 1)
+			return c->p;
+		chunk* x = _ca.allocate(1);
+		x->refs = 1;
+		x->p = _a.allocate(SIZET);
+		if(c != nullptr)
+		{
+			try
+			{
+				uninitialized_copy(_a, c->p + lo(k), c->p + hi(k), x->p + lo(k));
+			}
+			catch (...)
+			{
+				_a.deallocate(x->p, SIZET);
+				_ca.deallocate(x, 1);
+				throw;
+			}
+			release(c, lo(k), hi(k));
+		}
+		c = x;
+		return c->p;
+	}
+
+	///
+	/// Move the inner arrays in use to the middle of a larger circular outer array, in order, followed by the unused ones
+	/// The inner arrays keep their reference counts.
+	/// @param s - the minimum # of elements of the new outer array
+	///
+	void rebuild (size_type s)
+	{
+		assert(s >= count);
+		size_type outer = 2 * ((s + SIZET - 1) / SIZET) + 1;
+		assert(outer > map.size());
+		std::vector<chunk*> x(outer, nullptr);
+		size_type h = outer / 2;
+		for(size_type i = 0; i != map.size(); ++i)
+			x[(h + i) % outer] = slot(i);
+		map.swap(x);
+		head = h;
+		assert(valid());
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty CowDeque container
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit CowDeque (const allocator_type& a = allocator_type()) : _a (a), head (0), b (0), count (0)
+	{
+		assert(valid());
+	}
+
+	/**
+	* Create a CowDeque container with s elements, each of them a copy of v
+	* @param s - the # of elements
+	* @param v - an optional argument for a value used to initialize the container
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit CowDeque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) : _a (a), head (0), b (0), count (0)
+	{
+		resize(s, v);
+		assert(valid());
+	}
+
+	/**
+	* Copy Constructor - Share the inner arrays of another CowDeque container, in O(blocks)
+	* @param that - another CowDeque container
+	*/
+	CowDeque (const CowDeque& that) : _a (that._a), _ca (that._ca), map (that.map), head (that.head), b (that.b), count (that.count)
+	{
+		for(size_type i = 0; i != map.size(); ++i)
+			if(map[i] != nullptr)
+				__atomic_add_fetch(&map[i]->refs, 1, __ATOMIC_RELAXED);
+		assert(valid());
+	}
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Gives up every inner array, destroying the elements of the ones no other CowDeque container shares
+	*/
+	~CowDeque ()
+	{
+		for(size_type k = 0; k != map.size(); ++k)
+			release(slot(k), lo(k), hi(k));
+	}
+
+	// ----------
+	// operator =
+	// ----------
+
+	/**
+	* Copy Assignment Operator - Share the inner arrays of another CowDeque container
+	* @param that - another CowDeque container
+	* @return a reference to this CowDeque container
+	*/
+	CowDeque& operator = (const CowDeque& that)
+	{
+		if(this != &that)
+		{
+			CowDeque x(that);
+			swap(x);
+		}
+		return *this;
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator, which clones the inner array of the element if it is shared
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	*/
+	reference operator [] (size_type index)
+	{
+		return writable((b + index) / SIZET)[(b + index) % SIZET];
+	}
+
+	/**
+	* const subscript operator
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return slot((b + index) / SIZET)->p[(b + index) % SIZET];
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns a reference to the element at position index in the CowDeque container object
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the CowDeque container
+	*/
+	reference at (size_type index)
+	{
+		if(index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	/**
+	* Returns a const reference to the element at position index in the CowDeque container object
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the CowDeque container
+	*/
+	const_reference at (size_type index) const
+	{
+		if(index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return a reference to the last element of the CowDeque container
+	*/
+	reference back ()
+	{
+		assert(!empty());
+		return (*this)[count - 1];
+	}
+
+	/**
+	* Access last element
+	* @return a const reference to the last element of the CowDeque container
+	*/
+	const_reference back () const
+	{
+		assert(!empty());
+		return (*this)[count - 1];
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return an Iterator to the beginning of the CowDeque container
+	*/
+	iterator begin ()
+	{
+		return iterator(this, 0);
+	}
+
+	/**
+	* @return a Const Iterator to the beginning of the CowDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all elements of the CowDeque container and give up its inner arrays, without cloning the shared ones
+	*/
+	void clear ()
+	{
+		for(size_type k = 0; k != map.size(); ++k)
+			release(slot(k), lo(k), hi(k));
+		map.clear();
+		head = b = count = 0;
+		assert(valid());
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the CowDeque container is empty
+	* @return true if the CowDeque container contains zero elements
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return an Iterator to the end of the CowDeque container
+	*/
+	iterator end ()
+	{
+		return iterator(this, size());
+	}
+
+	/**
+	* @return a Const Iterator to the end of the CowDeque container
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array, without cloning any of them
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j && j <= count);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, j - i);
+			const_pointer x = &(*this)[i];
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return a reference to the first element of the CowDeque container
+	*/
+	reference front ()
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	/**
+	* Access first element
+	* @return a const reference to the first element of the CowDeque container
+	*/
+	const_reference front () const
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last element of the CowDeque container
+	*/
+	void pop_back ()
+	{
+		assert(!empty());
+		pointer x = writable((b + count - 1) / SIZET);
+		std::allocator_traits<A>::destroy(_a, x + (b + count - 1) % SIZET);
+		--count;
+		assert(valid());
+	}
+
+	/**
+	* Delete the first element of the CowDeque container
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		pointer x = writable(0);
+		std::allocator_traits<A>::destroy(_a, x + b);
+		++b;
+		--count;
+		if(b == USIZET)
+		{
+			head = (head + 1) % map.size();
+			b = 0;
+		}
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the CowDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_back (const_reference v)
+	{
+		if(b + count + 1 > map.size() * USIZET)
+		{
+			// v may be an element of the container, which stays put because rebuild moves only the outer array
+			rebuild(count + 1);
+		}
+		pointer x = writable((b + count) / SIZET);
+		uninitialized_fill(_a, x + (b + count) % SIZET, x + (b + count) % SIZET + 1, v);
+		++count;
+		assert(valid());
+	}
+
+	/**
+	* Add element to the front of the CowDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_front (const_reference v)
+	{
+		if(map.empty() || (b == 0 && count + SIZET > map.size() * USIZET))
+			rebuild(count + 1);
+		if(b == 0)
+		{
+			// The slot before the first inner array holds no elements, so cloning it copies none
+			pointer x = writable(map.size() - 1);
+			uninitialized_fill(_a, x + SIZET - 1, x + SIZET, v);
+			head = (head + map.size() - 1) % map.size();
+			b = SIZET - 1;
+		}
+		else
+		{
+			pointer x = writable(0);
+			uninitialized_fill(_a, x + b - 1, x + b, v);
+			--b;
+		}
+		++count;
+		assert(valid());
+	}
+
+	// ------
+	// resize
+	// ------
+
+	/**
+	* Change size of the CowDeque container
+	* @param s - new size for CowDeque container
+	* @param v - an optional argument whose data is copied to the new elements when the new size is greater than the current size
+	*/
+	void resize (size_type s, const_reference v = value_type())
+	{
+		while(count > s)
+			pop_back();
+		if(s > count && b + s > map.size() * USIZET)
+			rebuild(s);
+		while(count < s)
+			push_back(v);
+		assert(valid());
+	}
+
+	// -------------
+	// shared_blocks
+	// -------------
+
+	/**
+	* @return the # of inner arrays in use that the CowDeque container shares with another one
+	*/
+	size_type shared_blocks () const
+	{
+		size_type n = 0;
+		for(size_type k = 0; k * SIZET < b + count; ++k)
+			if(__atomic_load_n(&slot(k)->refs, __ATOMIC_RELAXED) > 1)
+				++n;
+		return n;
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of elements in the CowDeque container
+	*/
+	size_type size () const
+	{
+		return count;
+	}
+
+	// ----
+	// swap
+	// ----
+
+	/**
+	* Exchange the contents of two CowDeque containers
+	* @param that - another CowDeque container
+	*/
+	void swap (CowDeque& that)
+	{
+		std::swap(_a, that._a);
+		std::swap(_ca, that._ca);
+		map.swap(that.map);
+		std::swap(head, that.head);
+		std::swap(b, that.b);
+		std::swap(count, that.count);
+	}
+};
+
+#endif // CowDeque_h
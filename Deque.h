@@ -11,18 +11,72 @@
 // includes
 // --------
 
-#include <algorithm> // copy, equal, lexicographical_compare, max, swap
+#include <algorithm> // copy, equal, lexicographical_compare, max, move, swap
 #include <cassert>   // assert
-#include <iterator>  // iterator, bidirectional_iterator_tag
-#include <memory>    // allocator
-#include <stdexcept> // out_of_range
-#include <utility>   // !=, <=, >, >=
+#include <cerrno>    // errno, EINTR
+#include <cmath>     // ceil
+#include <istream>   // istream
+#include <iterator>  // iterator, bidirectional_iterator_tag, forward_iterator_tag, make_move_iterator
+#include <memory>    // allocator, allocator_traits, uninitialized_copy
+#include <ostream>   // ostream
+#include <stdexcept> // invalid_argument, length_error, logic_error, out_of_range, runtime_error
+#include <stdint.h>  // uint64_t, uintptr_t
+#include <system_error> // generic_category, system_error
+#include <type_traits> // is_trivially_copyable
+#include <utility>   // !=, <=, >, >=, pair
+#include <vector>    // vector
 #include <stddef.h>
 
+#include <sys/uio.h> // iovec, readv, writev
+
+#include "DequeLatency.h" // DequeLatency, DequeTimer
+#include "DequeStats.h" // DequeStats, DequeStatsRegistry
+#include "NumaAllocator.h" // numa::node
+#include "Spill.h"   // SpillFile, SpillStats
+
 // Global Constant
 const ptrdiff_t SIZET = 1000;
 const size_t USIZET = 1000;
 
+// Pinned Inner Arrays - how many of the inner arrays accessed last a MyDeque container with a memory budget keeps in memory,
+// so that references to their elements stay valid while other elements are accessed
+const size_t PINNED = 4;
+
+// Prefetch Distance - how many inner arrays ahead sequential iteration prefetches when it enters an inner array, and Prefetch
+// Lines - how many 64 byte cache lines of that inner array it and for_each_segment prefetch; both may be tuned at compile time
+// with -D
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 1
+#endif
+#ifndef PREFETCH_LINES
+#define PREFETCH_LINES 4
+#endif
+const size_t PREFETCHD = PREFETCH_DISTANCE;
+static_assert(PREFETCH_DISTANCE > 0, "PREFETCH_DISTANCE must be at least one inner array");
+
+#if defined(__GNUC__)
+#define DEQUE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define DEQUE_PREFETCH(p) ((void) (p))
+#endif
+
+// Instrumentation - compile with -DDEQUE_STATS to count the events of DequeStats for each MyDeque container and each MyDeque type;
+// otherwise the counting compiles to nothing
+// DEQUE_STATS adds members to MyDeque, and DEQUE_STATS and DEQUE_LATENCY change the code of its inline members, so every
+// translation unit of a program must agree on both; mixing them is an ODR violation that the linker does not diagnose
+#ifdef DEQUE_STATS
+#define DEQUE_COUNT(c, n) tally(&DequeStats::c, n)
+#else
+#define DEQUE_COUNT(c, n) ((void) 0)
+#endif
+
+// Latency - compile with -DDEQUE_LATENCY to record the wall time of the mutators of each MyDeque type in DequeLatencyRegistry
+#ifdef DEQUE_LATENCY
+#define DEQUE_TIME(op) DequeTimer _timer(latency(), DequeLatency::op)
+#else
+#define DEQUE_TIME(op) ((void) 0)
+#endif
+
 // -----
 // using
 // -----
@@ -51,7 +105,7 @@ BI destroy (A& a, BI b, BI e)
 	while (b != e) 
 	{
 		--e;
-		a.destroy(&*e);
+		std::allocator_traits<A>::destroy(a, &*e);
 	}
 	return b;
 }
@@ -79,7 +133,7 @@ BI uninitialized_copy (A& a, II b, II e, BI x)
 	{
 		while (b != e) 
 		{
-			a.construct(&*x, *b);
+			std::allocator_traits<A>::construct(a, &*x, *b);
 			++b;
 			++x;
 		}
@@ -115,7 +169,7 @@ BI uninitialized_fill (A& a, BI b, BI e, const U& v)
 	{
 		while (b != e) 
 		{
-			a.construct(&*b, v);
+			std::allocator_traits<A>::construct(a, &*b, v);
 			++b;
 		}
 	}
@@ -144,19 +198,45 @@ public:
 	// typedefs
 	// --------
 
-	typedef A                                        allocator_type;
-	typedef typename allocator_type::value_type      value_type;
+	typedef A                                                  allocator_type;
+	typedef typename std::allocator_traits<A>::value_type      value_type;
+
+	typedef typename std::allocator_traits<A>::size_type       size_type;
+	typedef typename std::allocator_traits<A>::difference_type difference_type;
 
-	typedef typename allocator_type::size_type       size_type;
-	typedef typename allocator_type::difference_type difference_type;
+	typedef typename std::allocator_traits<A>::pointer         pointer;
+	typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
 
-	typedef typename allocator_type::pointer         pointer;
-	typedef typename allocator_type::const_pointer   const_pointer;
+	typedef value_type&                                        reference;
+	typedef const value_type&                                  const_reference;
+
+	typedef typename std::allocator_traits<A>::template rebind_alloc<pointer> astar_type; 
+	typedef SpillFile<allocator_type>                                spill_type;
+
+	///
+	/// What push_back and push_front do when a fixed capacity MyDeque container is full
+	/// grow - the MyDeque container is not fixed capacity; it rebuilds a larger outer array
+	/// reject - throw a length_error exception, or return false from try_push_back and try_push_front
+	/// overwrite - remove the element at the opposite end of the MyDeque container
+	///
+	enum overflow_policy { grow, reject, overwrite };
 
-	typedef typename allocator_type::reference       reference;
-	typedef typename allocator_type::const_reference const_reference;
+	///
+	/// How a MyDeque container sizes its outer array
+	/// factor - a rebuilt outer array has factor times the inner arrays the elements need, plus one; at least 1, and 2 by default
+	/// front, back - the # of elements the fill and copy constructors leave room for before the first element and after the last one
+	/// The outer array is circular, so both ends draw on every free inner array; front and back together decide how many there
+	/// are, and front decides where the first element goes in its inner array.
+	///
+	struct growth_policy
+	{
+		double factor;
+		size_type front;
+		size_type back;
 
-	typedef typename allocator_type::template rebind<pointer>::other astar_type; 
+		growth_policy (double f = 2, size_type x = 0, size_type y = 0) : factor (f), front (x), back (y)
+		{}
+	};
 
 public:
 	// -----------
@@ -203,6 +283,18 @@ private:
 	ptrdiff_t b;
 	ptrdiff_t e;
 	size_type count;
+	overflow_policy policy;
+	size_type limit;
+	spill_type* spill;
+	pointer spare = pointer(); // an inner array given back by recycle, which take_front_block puts in the outer array
+	growth_policy growth = growth_policy();
+	difference_type bias = 0;  // the # of push_back calls minus the # of push_front calls, which a copy inherits
+	pointer pins[PINNED] = {}; // the inner arrays accessed last with a memory budget, which shed does not spill
+	size_type pin = 0;         // the slot of pins holding the inner array accessed last
+	#ifdef DEQUE_STATS
+	DequeStats _stats = DequeStats();
+	DequeStats* _sink = &_stats; // the counters of the container, which a temporary rebuilt container shares
+	#endif
 
 private:
 	// -----
@@ -217,12 +309,263 @@ private:
 		// Empty
 		if (cb == 0 && ce == 0 && pb == 0 && pe == 0 && b == 0 && e == 0 && count == 0)
 			return true;
-		// Non-Empty Non Circular
-		if(cb <= pb && pb <= pe && pe <= ce && b >= 0 && b <= SIZET && e >= 0 && e < SIZET && count >= 0)
+		// Non-Empty Circular
+		if(cb < ce && cb <= pb && pb < ce && cb <= pe && pe < ce && b >= 0 && b < SIZET && e >= 0 && e < SIZET && b + count <= capacity())
 			return true;
 		return false;
 	}
 
+	///
+	/// @return the number of elements the outer array can hold, including the unused front of the first inner array
+	///
+	size_type capacity () const
+	{
+		return (ce - cb) * USIZET;
+	}
+
+	///
+	/// Find an inner array of the circular outer array
+	/// @param n - the number of inner arrays after the first inner array
+	/// @return a pointer to the outer array slot that is n slots after pb, wrapping around at ce
+	///
+	pointer* block (size_type n) const
+	{
+		return cb + ((pb - cb) + n) % (ce - cb);
+	}
+
+	///
+	/// Regenerate the pe and e pointers from the pb and b pointers and the size of the container
+	///
+	void set_end ()
+	{
+		if(cb == nullptr)
+			return;
+		pe = block((b + count) / SIZET);
+		e = (b + count) % SIZET;
+	}
+
+	///
+	/// @param p - an outer array slot
+	/// @return true if the slot holds the spill file offset of an inner array instead of a pointer
+	///
+	static bool spilled (pointer p)
+	{
+		return reinterpret_cast<uintptr_t>(p) & 1;
+	}
+
+	///
+	/// Make an inner array of a MyDeque container with a memory budget resident
+	/// Allocates the inner array if it was never used, or reads it back from the spill file,
+	/// and then spills other inner arrays if the container is over its memory budget
+	/// @param x - a pointer to an outer array slot
+	/// @return the inner array
+	///
+	pointer load (pointer* x)
+	{
+		if(spill == nullptr)
+			return *x;
+		if(*x == nullptr || spilled(*x))
+		{
+			if(*x == nullptr)
+				DEQUE_COUNT(block_allocations, 1);
+			*x = (*x == nullptr) ? spill->allocate() : spill->fill(reinterpret_cast<uintptr_t>(*x) >> 1);
+			shed(((x - pb) + (ce - cb)) % (ce - cb));
+		}
+		if(pins[pin] != *x)
+		{
+			pin = (pin + 1) % PINNED;
+			pins[pin] = *x;
+		}
+		return *x;
+	}
+
+	///
+	/// @param p - an inner array
+	/// @return true if the inner array is one of the PINNED inner arrays accessed last
+	///
+	bool pinned (pointer p) const
+	{
+		return std::find(pins, pins + PINNED, p) != pins + PINNED;
+	}
+
+	///
+	/// Spill inner arrays until the MyDeque container is within its memory budget
+	/// The two inner arrays at each end, the inner arrays next to inner array k and the pinned inner arrays stay in memory
+	/// @param k - the number of inner arrays after the first inner array of the inner array being used
+	///
+	void shed (ptrdiff_t k)
+	{
+		ptrdiff_t lo = 2;
+		ptrdiff_t hi = static_cast<ptrdiff_t>((b + count + SIZET - 1) / SIZET) - 3;
+		bool back = true;
+		while(spill->over() && lo <= hi)
+		{
+			ptrdiff_t i = back ? hi-- : lo++;
+			back = !back;
+			pointer* x = block(i);
+			if((i < k - 1 || i > k + 1) && *x != nullptr && !spilled(*x) && !pinned(*x))
+				*x = reinterpret_cast<pointer>(static_cast<uintptr_t>(spill->write(*x)) << 1 | 1);
+		}
+	}
+
+	///
+	/// Prefetch the first or last cache lines of an inner array, and the outer array slot after or before it
+	/// @param k - the number of inner arrays after the first inner array
+	/// @param tail - true to prefetch the end of the inner array and the slot before it, for backward iteration
+	///
+	void prefetch_block (size_type k, bool tail) const
+	{
+		const char* p = reinterpret_cast<const char*>(*block(k));
+		if(tail)
+			p += SIZET * sizeof(value_type) - PREFETCH_LINES * 64;
+		for(int i = 0; i < PREFETCH_LINES; ++i)
+			DEQUE_PREFETCH(p + i * 64);
+		DEQUE_PREFETCH(tail ? block(k - 1 + (ce - cb)) : block(k + 1));
+	}
+
+	///
+	/// Prefetch the inner array PREFETCHD inner arrays ahead of the one sequential iteration just entered
+	/// @param index - the element position iteration moved to, the first or, backward, the last of an inner array
+	/// @param forward - true if iteration moves forward
+	///
+	void prefetch_ahead (size_type index, bool forward) const
+	{
+		size_type k = (index + b) / SIZET;
+		if(forward && (k + PREFETCHD) * SIZET < b + count)
+			prefetch_block(k + PREFETCHD, false);
+		else if(!forward && k >= PREFETCHD && index < count)
+			prefetch_block(k - PREFETCHD, true);
+	}
+
+	///
+	/// Free an inner array of a MyDeque container with a memory budget, whether it is resident or spilled
+	/// @param x - a pointer to an outer array slot
+	///
+	void unload (pointer* x)
+	{
+		if(spilled(*x))
+			spill->discard(reinterpret_cast<uintptr_t>(*x) >> 1);
+		else if(*x != nullptr)
+			spill->release(*x);
+		if(*x != nullptr)
+			DEQUE_COUNT(block_frees, 1);
+		*x = nullptr;
+	}
+
+	///
+	/// Start reading a spilled inner array back on another thread
+	/// @param x - a pointer to an outer array slot
+	///
+	void prefetch (pointer* x)
+	{
+		if(spilled(*x))
+			spill->prefetch(reinterpret_cast<uintptr_t>(*x) >> 1);
+	}
+
+	#ifdef DEQUE_STATS
+	///
+	/// Count an event for the MyDeque container and for its type
+	/// @param c - the counter of the event
+	/// @param n - the # of events
+	///
+	void tally (std::size_t DequeStats::* c, size_type n)
+	{
+		static DequeStats& total = DequeStatsRegistry::instance().add(typeid(MyDeque));
+		_sink->*c += n;
+		DequeStatsRegistry::count(total, c, n);
+	}
+	#endif
+
+	#ifdef DEQUE_LATENCY
+	///
+	/// @return the latency histograms of the MyDeque type
+	///
+	static DequeLatency& latency ()
+	{
+		static DequeLatency& x = DequeLatencyRegistry::instance().add(typeid(MyDeque));
+		return x;
+	}
+	#endif
+
+	///
+	/// Read or write the live ranges of inner arrays with as few system calls as possible
+	/// @param fd - a file descriptor
+	/// @param v - the live ranges, which are consumed
+	/// @param n - the number of live ranges
+	/// @param out - true to write the live ranges, false to read them
+	/// @throws system_error exception if a system call fails
+	/// @throws runtime_error exception if the file ends before the live ranges are read
+	///
+	static void transfer (int fd, iovec* v, size_type n, bool out)
+	{
+		while(n != 0)
+		{
+			ssize_t r = out ? writev(fd, v, std::min<size_type>(n, 1024)) : readv(fd, v, std::min<size_type>(n, 1024));
+			if(r < 0 && errno == EINTR)
+				continue;
+			if(r < 0)
+				throw std::system_error(errno, std::generic_category(), out ? "writev" : "readv");
+			if(r == 0 && !out)
+				throw std::runtime_error("deque::deserialize");
+			// Skip the live ranges that are done and advance into the first one that is not
+			for(; n != 0 && static_cast<size_type>(r) >= v->iov_len; --n, ++v)
+				r -= v->iov_len;
+			if(n != 0)
+			{
+				v->iov_base = static_cast<char*>(v->iov_base) + r;
+				v->iov_len -= r;
+			}
+		}
+	}
+
+	///
+	/// Read or write the elements [i, s) of the MyDeque container, one live range of an inner array at a time
+	/// The live ranges are gathered into one system call, except with a memory budget, where loading an inner array may spill another
+	/// @param fd - a file descriptor
+	/// @param i - the index of the first element
+	/// @param s - the index one past the last element
+	/// @param out - true to write the elements, false to read them and count them as they arrive
+	///
+	void ia_transfer (int fd, size_type i, size_type s, bool out)
+	{
+		std::vector<iovec> v;
+		while(i != s)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, s - i);
+			iovec x = {&(*this)[i], n * sizeof(value_type)};
+			v.push_back(x);
+			i += n;
+			if(spill != nullptr || v.size() == 1024 || i == s)
+			{
+				transfer(fd, &v[0], v.size(), out);
+				v.clear();
+				if(!out)
+				{
+					count = i;
+					set_end();
+				}
+			}
+		}
+	}
+
+	///
+	/// Make room for the elements of a serialized MyDeque container
+	/// @param s - the number of elements
+	/// @param front - the offset of the first element in the first inner array of the serialized container
+	///
+	void prepare (size_type s, size_type front)
+	{
+		clear();
+		if (limit != 0 && s > limit)
+			throw std::length_error("deque::deserialize");
+		if (cb == nullptr || b + s > capacity())
+			rebuild(s);
+		// Keep the serialized inner array boundaries if they fit
+		if (front < USIZET && front + s <= capacity())
+			b = front;
+		set_end();
+	}
+
 	///
 	/// Fill the MyDeque container's inner arrays with specified value
 	/// @param add - the number of elements to be added to the MyDeque container
@@ -261,6 +604,41 @@ private:
 		}
 	}
 
+	///
+	/// Fill the MyDeque container's inner arrays after its last element with specified value, wrapping around at ce
+	/// @param add - the number of elements to be added to the MyDeque container, which must fit in its capacity
+	/// @param v - the value used to construct the elements of the MyDeque container
+	///
+	void fill_back (size_type add, const_reference v)
+	{
+		for(size_type n; add != 0; add -= n)
+		{
+			n = std::min<size_type>(add, SIZET - e);
+			uninitialized_fill(_a, *pe + e, *pe + e + n, v);
+			count += n;
+			set_end();
+		}
+	}
+
+	///
+	/// Copy elements from another container to the MyDeque container's inner arrays after its last element, wrapping around at ce
+	/// @tparam RI - a random access iterator
+	/// @param add - the number of elements to be added to the MyDeque container, which must fit in its capacity
+	/// @param bIter - an random access iterator at the beginning of the range to be copied
+	///
+	template<typename RI>
+	void copy_back (size_type add, RI bIter)
+	{
+		for(size_type n; add != 0; add -= n)
+		{
+			n = std::min<size_type>(add, SIZET - e);
+			uninitialized_copy(_a, bIter, bIter + n, *pe + e);
+			bIter += n;
+			count += n;
+			set_end();
+		}
+	}
+
 	/// Copy elements from another container to the MyDeque container by swapping inner arrays
 	/// @param begin - a pointer to the beginning of the source range
 	/// @param end - a pointer to the end of the source range
@@ -285,7 +663,10 @@ private:
 	{
 		while(_b != _e)
 		{
-			*_b = _a.allocate(SIZET);
+			// A MyDeque container with a memory budget allocates inner arrays when they are first used
+			*_b = (spill == nullptr) ? _a.allocate(SIZET) : nullptr;
+			if(spill == nullptr)
+				DEQUE_COUNT(block_allocations, 1);
 			++_b;
 		}
 		b = 0;
@@ -306,12 +687,42 @@ private:
 		count = 0;
 	}
 
+	///
+	/// Allocate an outer array for an empty MyDeque container, with room for s elements and the headroom of the growth policy
+	/// Without headroom, a container that was grown more at the front puts the free part of the partially filled inner array
+	/// before the first element, so its first push_front needs no rebuild.
+	/// @param s - the number of elements the container will hold
+	///
+	void place (size_type s)
+	{
+		size_type front = growth.front;
+		if(front == 0 && growth.back == 0 && bias < 0)
+			front = (SIZET - s % SIZET) % SIZET;
+		size_type outer_array = (front + s + growth.back + SIZET - 1) / SIZET;
+		if(outer_array == 0)
+		{
+			set_deque_ptr();
+			return;
+		}
+		cb = _astar.allocate(outer_array);
+		ce = cb + outer_array;
+		allocate(cb, ce);
+		pb = cb + front / SIZET;
+		b = front % SIZET;
+		count = 0;
+		set_end();
+	}
+
 	///
 	/// Replicate the MyDeque container and expand the capacity of the container 
 	/// @param s - the minimum capacity of the new MyDeque container
 	///
 	void rebuild(size_type s)
 	{
+		// A fixed capacity MyDeque container never allocates after construction
+		assert(limit == 0);
+		DEQUE_COUNT(rebuilds, 1);
+		DEQUE_COUNT(rebuilt_elements, size());
 		MyDeque x(*this, s);
 		this->swap(x);
 	}
@@ -321,41 +732,93 @@ private:
 	/// @param that - an other MyDeque container
 	/// @param s - the minimum capacity of the new MyDeque container
 	///
-	MyDeque (MyDeque& that, size_type s) : _a (that._a) 
+	MyDeque (MyDeque& that, size_type s) : _a (that._a), policy (that.policy), limit (that.limit), spill (that.spill), spare (that.spare), growth (that.growth), bias (that.bias), pin (that.pin) 
 	{
+		std::copy(that.pins, that.pins + PINNED, pins);
+		that.spill = nullptr;
+		that.spare = nullptr;
+		#ifdef DEQUE_STATS
+		_sink = that._sink;
+		#endif
 		assert(s >= that.size());
 		// # of outer arrays used to store old data
-		size_type copy_array = (that.size() % SIZET) ? that.size() / SIZET + 1 : that.size() / SIZET;
-		// # of outer arrays for the rebuilt MyDeque
+		size_type copy_array = (that.cb == nullptr) ? 0 : (that.b + that.size() + SIZET - 1) / SIZET;
+		// # of outer arrays for the rebuilt MyDeque, grown by the factor of the growth policy; 2 * n + 1 by default
 		size_type outer_array = (s % SIZET) ? s / SIZET + 1 : s / SIZET;
-		((outer_array *= 2) % 2) ? outer_array : outer_array += 1;
+		outer_array = static_cast<size_type>(std::ceil(growth.factor * outer_array)) + 1;
 		// Allocate Memory
 		cb = _astar.allocate(outer_array);
 		ce = cb + outer_array;
-		pb = cb + outer_array / 2;
-		pe = pb + copy_array;
+		// The old inner arrays go in the middle, or as far toward it as they fit without wrapping around with a small factor
+		pb = cb + std::min<size_type>(outer_array / 2, outer_array - copy_array);
 		allocate(cb, ce);
 
-		// Copy old data
+		// Copy old data - the old outer array may wrap around at that.ce
 		if(copy_array > 0)
 		{
-			if(that.e > 0)
-			{
-				ia_copy(that.pb, that.pe + 1, this->pb);
-				--pe;
-			}
-			else
-			{
-				ia_copy(that.pb, that.pb + copy_array, this->pb);
-			}
+			size_type front_array = std::min<size_type>(copy_array, that.ce - that.pb);
+			ia_copy(that.pb, that.pb + front_array, this->pb);
+			ia_copy(that.cb, that.cb + (copy_array - front_array), this->pb + front_array);
 			b = that.b;
-			e = that.e;
 		}
 		this->count = that.count;
 		that.count = 0;
+		set_end();
+		if(spill != nullptr)
+			spill->resident(std::count_if(cb, ce, [] (pointer p) {return p != nullptr && !spilled(p);}));
 		assert(valid());
 	}
 
+	///
+	/// Make room for one more element in a full fixed capacity MyDeque container
+	/// @param front - true if the new element will be added to the front of the container
+	/// @throws length_error exception if the overflow policy is reject
+	///
+	void overflow (bool front)
+	{
+		assert(full());
+		if(policy != overwrite)
+			throw std::length_error("deque::overflow");
+		if(front)
+			pop_back();
+		else
+			pop_front();
+	}
+
+	///
+	/// Remove the first k elements, which must have been destroyed or moved out, from the MyDeque container
+	/// @param k - the # of elements, which must all be in the first inner array
+	///
+	void drop_front (size_type k)
+	{
+		assert(k <= count && b + k <= SIZET);
+		b += k;
+		count -= k;
+		if(b == SIZET)
+		{
+			// A MyDeque container with a memory budget frees the inner array, and prefetches the inner arrays approaching the front
+			if(spill != nullptr)
+				unload(pb);
+			pb = block(1);
+			b = 0;
+			if(spill != nullptr && count > SIZET)
+			{
+				prefetch(block(1));
+				prefetch(block(2));
+			}
+		}
+		set_end();
+	}
+
+	///
+	/// @param that - another MyDeque container
+	/// @return true if either container can take over the outer array and inner arrays of the other one
+	///
+	bool adoptable (const MyDeque& that) const
+	{
+		return limit == 0 && that.limit == 0 && spill == nullptr && that.spill == nullptr && _a == that._a;
+	}
+
 public:
 	// --------------
 	// const_iterator
@@ -474,6 +937,14 @@ public:
 		// ~const_iterator ();
 		// const_iterator& operator = (const const_iterator&);
 
+		/**
+		* @return the index of the Const_Iterator
+		*/
+		size_type index () const
+		{
+			return _index;
+		}
+
 		// ----------
 		// operator *
 		// ----------
@@ -512,6 +983,8 @@ public:
 		const_iterator& operator ++ () 
 		{
 			++_index;
+			if(_p != nullptr && (_index + _p->b) % SIZET == 0)
+				_p->prefetch_ahead(_index, true);
 			assert(valid());
 			return *this;
 		}
@@ -540,6 +1013,8 @@ public:
 		const_iterator& operator -- () 
 		{
 			--_index;
+			if(_p != nullptr && (_index + _p->b) % SIZET == USIZET - 1)
+				_p->prefetch_ahead(_index, false);
 			assert(valid());
 			return *this;
 		}
@@ -708,6 +1183,14 @@ public:
 		// ~iterator ();
 		// iterator& operator = (const iterator&);
 
+		/**
+		* @return the index of the Iterator
+		*/
+		size_type index () const
+		{
+			return _index;
+		}
+
 		// ----------
 		// operator *
 		// ----------
@@ -746,6 +1229,8 @@ public:
 		iterator& operator ++ () 
 		{
 			++_index;
+			if(_p != nullptr && (_index + _p->b) % SIZET == 0)
+				_p->prefetch_ahead(_index, true);
 			assert(valid());
 			return *this;
 		}
@@ -774,6 +1259,8 @@ public:
 		iterator& operator -- () 
 		{
 			--_index;
+			if(_p != nullptr && (_index + _p->b) % SIZET == USIZET - 1)
+				_p->prefetch_ahead(_index, false);
 			assert(valid());
 			return *this;
 		}
@@ -830,88 +1317,404 @@ public:
 
 	};
 
-public:
-	// ------------
-	// constructors
-	// ------------
+	// ----------
+	// block_span
+	// ----------
 
-	/**
-	* Default Constructor - Empty MyDeque
-	* @param a - an optional argument for an allocator object
-	*/
-	explicit MyDeque (const allocator_type& a = allocator_type()) : _a (a)
+	///
+	/// An inner array detached from a MyDeque container by take_front_block, which owns the elements [begin(), end())
+	/// Destroying a block_span destroys its elements and frees the inner array; recycle gives the inner array back to a MyDeque container
+	///
+	class block_span
 	{
-		set_deque_ptr();
-		assert(valid());
-	}
+		friend class MyDeque;
 
-	/**
-	* Fill Constructor - Create MyDeque with specified size and type
-	* @param s - Initial Container Size
-	* @param v - an optional argument for a value used to initialize the container
-	* @param a - an optional argument for an allocator object
-	*/
-	explicit MyDeque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) : _a (a), count(s)
-	{
-		if(s != 0)
+	private:
+		// ----
+		// data
+		// ----
+
+		allocator_type _a;
+		pointer _p; // the inner array, or nullptr
+		pointer _b;
+		pointer _e;
+
+		block_span (const allocator_type& a, pointer p, pointer b, pointer e) : _a (a), _p (p), _b (b), _e (e)
+		{}
+
+	public:
+		/**
+		* Create an empty block_span
+		*/
+		block_span () : _p (nullptr), _b (nullptr), _e (nullptr)
+		{}
+
+		/**
+		* Move Constructor - Take the inner array of another block_span
+		* @param that - another block_span, which becomes empty
+		*/
+		block_span (block_span&& that) : _a (that._a), _p (that._p), _b (that._b), _e (that._e)
 		{
-			size_type outer_array = (s % SIZET) ? s / SIZET + 1 : s / SIZET;
-			pb = cb = _astar.allocate(outer_array);
-			pe = (s < USIZET) ? pb + outer_array - 1 : pb + outer_array;
-			ce = cb + outer_array;
-			allocate(cb, ce);
-			ia_fill(s, v, pb);
+			that._p = that._b = that._e = nullptr;
 		}
-		else
+
+		block_span (const block_span&) = delete;
+		block_span& operator = (const block_span&) = delete;
+
+		/**
+		* Move Assignment Operator - Exchange the inner arrays of two block_spans
+		* @param that - another block_span
+		* @return a reference to this block_span
+		*/
+		block_span& operator = (block_span&& that)
 		{
-			set_deque_ptr();
+			std::swap(_a, that._a);
+			std::swap(_p, that._p);
+			std::swap(_b, that._b);
+			std::swap(_e, that._e);
+			return *this;
 		}
-		assert(valid());
-	}
 
-	/**
-	* Copy Constructor - Create a copy of a MyDeque container 
-	* @param that - another MyDeque object
-	*/
-	MyDeque (const MyDeque& that) : _a (that._a)
-	{
-		count = that.size();
-		if(count != 0)
+		/**
+		* Destructor - Destroys the elements and frees the inner array
+		*/
+		~block_span ()
 		{
-			size_type outer_array = (that.size() % SIZET) ? that.size() / SIZET + 1 : that.size() / SIZET;
-			pb = cb = _astar.allocate(outer_array);
-			pe = pb + outer_array;
-			ce = cb + outer_array;
-			allocate(cb, ce);
-			ia_copy(that.size(), that.begin(), pb);
+			if(_p != nullptr)
+			{
+				destroy(_a, _b, _e);
+				_a.deallocate(_p, SIZET);
+			}
 		}
-		else
+
+		/**
+		* @param i - element position in the block_span
+		* @return a reference to the element
+		*/
+		reference operator [] (size_type i) const
 		{
-			set_deque_ptr();
+			return _b[i];
 		}
-		assert(valid());
-	}
-
-	// ----------
-	// destructor
-	// ----------
 
-	/**
-	* Destructor - Destroys all objects and Deallocates all memory for MyDeque container
-	*/
-	~MyDeque () 
-	{
-		if(cb)
+		/**
+		* @return a pointer to the first element
+		*/
+		pointer begin () const
 		{
-			clear();
-			pointer* x = cb;
+			return _b;
+		}
+
+		/**
+		* @return true if the block_span holds no elements
+		*/
+		bool empty () const
+		{
+			return _b == _e;
+		}
+
+		/**
+		* @return a pointer past the last element
+		*/
+		pointer end () const
+		{
+			return _e;
+		}
+
+		/**
+		* @return the # of elements
+		*/
+		size_type size () const
+		{
+			return _e - _b;
+		}
+	};
+
+	// ------------
+	// segment_view
+	// ------------
+
+	///
+	/// The contiguous segments of a range of elements of a MyDeque container, one per inner array
+	/// The first segment starts at the offset of the range in its inner array and the last one ends with the range.
+	/// Without a memory budget, the segments stay valid until the container is modified; with one, a segment may be spilled
+	/// as soon as the next one is read. The view that grow_back_uninitialized returns covers raw memory past the end.
+	/// @tparam C - MyDeque, const qualified for a view of const elements
+	/// @tparam P - pointer or const_pointer
+	///
+	template <typename C, typename P>
+	class segment_view
+	{
+		friend class MyDeque;
+
+	public:
+		typedef std::pair<P, size_type> value_type; // a pointer to the first element of a segment and its # of elements
+
+		///
+		/// A forward iterator over the segments of a segment_view
+		///
+		class iterator
+		{
+		public:
+			typedef std::forward_iterator_tag         iterator_category;
+			typedef typename segment_view::value_type value_type;
+			typedef typename MyDeque::difference_type difference_type;
+			typedef const value_type*                 pointer;
+			typedef value_type                        reference;
+
+		private:
+			C* _p;
+			size_type _i; // the index of the first element of the segment
+			size_type _j; // the index one past the last element of the range
+
+		public:
+			iterator (C* p = nullptr, size_type i = 0, size_type j = 0) : _p (p), _i (i), _j (j)
+			{}
+
+			friend bool operator == (const iterator& lhs, const iterator& rhs)
+			{
+				return (lhs._p == rhs._p) && (lhs._i == rhs._i);
+			}
+
+			friend bool operator != (const iterator& lhs, const iterator& rhs)
+			{
+				return !(lhs == rhs);
+			}
+
+			/**
+			* @return the segment
+			*/
+			value_type operator * () const
+			{
+				return value_type(&(*_p)[_i], length());
+			}
+
+			/**
+			* @return the # of elements of the segment
+			*/
+			size_type length () const
+			{
+				return std::min<size_type>(SIZET - (_p->b + _i) % SIZET, _j - _i);
+			}
+
+			iterator& operator ++ ()
+			{
+				_i += length();
+				return *this;
+			}
+
+			iterator operator ++ (int)
+			{
+				iterator x = *this;
+				++(*this);
+				return x;
+			}
+		};
+
+	private:
+		C* _p;
+		size_type _i;
+		size_type _j;
+
+		segment_view (C* p, size_type i, size_type j) : _p (p), _i (i), _j (j)
+		{
+			assert(i <= j && (i == j || p->b + j <= p->capacity()));
+		}
+
+	public:
+		/**
+		* @return an iterator to the first segment
+		*/
+		iterator begin () const
+		{
+			return iterator(_p, _i, _j);
+		}
+
+		/**
+		* @return an iterator past the last segment
+		*/
+		iterator end () const
+		{
+			return iterator(_p, _j, _j);
+		}
+
+		/**
+		* @return the # of bytes of the range
+		*/
+		size_type bytes () const
+		{
+			return (_j - _i) * sizeof(typename MyDeque::value_type);
+		}
+
+		/**
+		* @return the # of segments
+		*/
+		size_type size () const
+		{
+			return (_i == _j) ? 0 : (_p->b + _j - 1) / SIZET - (_p->b + _i) / SIZET + 1;
+		}
+
+		/**
+		* Describe the segments for readv, writev, sendmsg or recvmsg
+		* @param v - an array of at least size() iovecs
+		* @return the # of iovecs filled in
+		* @throws logic_error exception if the container has a memory budget, whose inner arrays may be spilled
+		*/
+		size_type iovecs (iovec* v) const
+		{
+			if(_p->spill != nullptr)
+				throw std::logic_error("deque::segments");
+			size_type n = 0;
+			for(iterator i = begin(); i != end(); ++i, ++n)
+			{
+				value_type x = *i;
+				v[n].iov_base = const_cast<typename MyDeque::value_type*>(x.first);
+				v[n].iov_len = x.second * sizeof(typename MyDeque::value_type);
+			}
+			return n;
+		}
+
+		/**
+		* Describe the segments for readv, writev, sendmsg or recvmsg
+		* @return an iovec for each segment
+		* @throws logic_error exception if the container has a memory budget, whose inner arrays may be spilled
+		*/
+		std::vector<iovec> iovecs () const
+		{
+			if(_p->spill != nullptr)
+				throw std::logic_error("deque::segments");
+			std::vector<iovec> v(size());
+			if(!v.empty())
+				iovecs(&v[0]);
+			return v;
+		}
+	};
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Default Constructor - Empty MyDeque
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit MyDeque (const allocator_type& a = allocator_type()) : _a (a), policy (grow), limit (0), spill (nullptr)
+	{
+		set_deque_ptr();
+		assert(valid());
+	}
+
+	/**
+	* Create an empty MyDeque with the headroom and growth factor of a growth policy
+	* @param g - the growth policy
+	* @param a - an optional argument for an allocator object
+	* @throws invalid_argument exception if the growth factor is less than 1
+	*/
+	explicit MyDeque (const growth_policy& g, const allocator_type& a = allocator_type()) : _a (a), policy (grow), limit (0), spill (nullptr), growth (g)
+	{
+		if(!(g.factor >= 1))
+			throw std::invalid_argument("deque::deque");
+		place(0);
+		assert(valid());
+	}
+
+	/**
+	* Fill Constructor - Create MyDeque with specified size and type
+	* @param s - Initial Container Size
+	* @param v - an optional argument for a value used to initialize the container
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit MyDeque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) : MyDeque (s, v, growth_policy(), a)
+	{}
+
+	/**
+	* Fill Constructor - Create MyDeque with specified size and type, and the headroom and growth factor of a growth policy
+	* @param s - Initial Container Size
+	* @param v - a value used to initialize the container
+	* @param g - the growth policy
+	* @param a - an optional argument for an allocator object
+	* @throws invalid_argument exception if the growth factor is less than 1
+	*/
+	MyDeque (size_type s, const_reference v, const growth_policy& g, const allocator_type& a = allocator_type()) : _a (a), policy (grow), limit (0), spill (nullptr), growth (g)
+	{
+		if(!(g.factor >= 1))
+			throw std::invalid_argument("deque::deque");
+		place(s);
+		fill_back(s, v);
+		assert(valid());
+	}
+
+	/**
+	* Fixed Capacity Constructor - Create an empty MyDeque that allocates all of its memory up front and never allocates again
+	* @param s - the maximum number of elements of the container
+	* @param p - what push_back and push_front do when the container is full: reject or overwrite
+	* @param a - an optional argument for an allocator object
+	*/
+	MyDeque (size_type s, overflow_policy p, const allocator_type& a = allocator_type()) : _a (a), count(0), policy (p), limit (s), spill (nullptr)
+	{
+		assert(s != 0 && p != grow);
+		// Leave room for b to be anywhere in the first inner array
+		size_type outer_array = (s + 2 * SIZET - 2) / SIZET;
+		pb = pe = cb = _astar.allocate(outer_array);
+		ce = cb + outer_array;
+		allocate(cb, ce);
+		assert(valid());
+	}
+
+	/**
+	* Copy Constructor - Create a copy of a MyDeque container 
+	* A copy of a fixed capacity MyDeque container has the same capacity and overflow policy
+	* @param that - another MyDeque object
+	*/
+	MyDeque (const MyDeque& that) : _a (that._a), policy (that.policy), limit (that.limit), spill (nullptr), growth (that.growth), bias (that.bias)
+	{
+		if(limit != 0)
+		{
+			size_type outer_array = that.ce - that.cb;
+			pb = cb = _astar.allocate(outer_array);
+			ce = cb + outer_array;
+			allocate(cb, ce);
+			count = 0;
+			set_end();
+		}
+		else
+			place(that.size());
+		copy_back(that.size(), that.begin());
+		assert(valid());
+	}
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Destroys all objects and Deallocates all memory for MyDeque container
+	*/
+	~MyDeque () 
+	{
+		if(cb)
+		{
+			clear();
+			pointer* x = cb;
 			while(x != ce)
 			{
-				_a.deallocate(*x, SIZET);
+				if(spill != nullptr)
+					unload(x);
+				else if(*x != nullptr)
+				{
+					_a.deallocate(*x, SIZET);
+					DEQUE_COUNT(block_frees, 1);
+				}
 				++x;
 			}
 			_astar.deallocate(cb, ce - cb);
 		}
+		if(spare != nullptr)
+		{
+			_a.deallocate(spare, SIZET);
+			DEQUE_COUNT(block_frees, 1);
+		}
+		delete spill;
 		assert(valid());
 	}
 
@@ -926,11 +1729,14 @@ public:
 	*/
 	MyDeque& operator = (const MyDeque& that) 
 	{
+		DEQUE_TIME(assign);
 		if (this == &that)
 			return *this;
+		if (limit != 0 && that.size() > limit)
+			throw std::length_error("deque::operator=");
 
-		// capacity = the number of elements from the allocated end to max end
-		size_type capacity = (cb == nullptr) ? 0 : (ce - pb) * SIZET;
+		// capacity = the number of elements from the beginning to the wrap around point of the outer array
+		size_type capacity = (cb == nullptr) ? 0 : this->capacity() - b;
 		if (that.size() == this->size()) // Equal Size
 		{	
 			std::copy(that.begin(), that.end(), this->begin());
@@ -955,14 +1761,7 @@ public:
 		}
 
 		// Regenerate pe and e pointers
-		if(cb != nullptr)
-		{
-			size_type offsetBOA = pb - cb;
-			size_type outer_array_index = (this->size() + b) / SIZET + offsetBOA;
-			size_type inner_array_index = (this->size() + b) % SIZET;
-			pe = cb + outer_array_index;
-			e = inner_array_index;
-		}
+		set_end();
 
 		assert(valid());
 		return *this;
@@ -974,22 +1773,25 @@ public:
 
 	/**
 	* subscript operator
+	* With a memory budget, the reference stays valid until elements of PINNED other inner arrays have been accessed or the
+	* container is modified.
 	* @param index - element position in the container
 	* @return a reference to the element at the position in the container
 	*/
 	reference operator [] (size_type index) 
 	{
 		static value_type dummy;
+		DEQUE_COUNT(subscripts, 1);
 		if(cb == nullptr)
 			return dummy;
-		size_type offsetBOA = pb - cb;
-		size_type outer_array_index = (index + b) / SIZET + offsetBOA;
-		size_type inner_array_index = (index + b) % SIZET;
-		return cb[outer_array_index][inner_array_index];
+		return load(block((index + b) / SIZET))[(index + b) % SIZET];
 	}
 
 	/**
 	* const subscript operator
+	* A MyDeque container with a memory budget reads a spilled inner array back here, which modifies the container,
+	* so even a const one is not safe for concurrent readers.
+	* The reference stays valid until elements of PINNED other inner arrays have been accessed or the container is modified.
 	* @param index - element position in the container
 	* @return a const reference to the element at the position in the container
 	*/
@@ -998,6 +1800,77 @@ public:
 		return const_cast<MyDeque*>(this)->operator[](index);
 	}
 
+	// ------
+	// append
+	// ------
+
+	/**
+	* Move the elements of another MyDeque container to the end of this one, leaving the other one empty
+	* When the other container starts at the offset where this one ends, its inner arrays are taken over by pointer and at
+	* most one inner array of elements is moved into the last inner array of this one. Otherwise the inner arrays of the
+	* larger container are kept by pointer and only the elements of the smaller one are moved, because all inner arrays of
+	* a MyDeque container share the offset b of the first element.
+	* @param that - another MyDeque container
+	* @throws length_error exception if a fixed capacity container cannot hold the elements
+	*/
+	void append (MyDeque&& that)
+	{
+		assert(this != &that);
+		if(limit != 0 && count + that.count > limit)
+			throw std::length_error("deque::append");
+		if(!empty() && !that.empty() && e == that.b && adoptable(that))
+		{
+			if(b + count + that.count > capacity())
+				rebuild(count + that.count);
+			// The elements of the first inner array of the other container go to the same offsets of the last one of this one
+			size_type n = (e == 0) ? 0 : std::min<size_type>(SIZET - e, that.count);
+			if(n != 0)
+			{
+				pointer y = &that[0];
+				uninitialized_copy(_a, std::make_move_iterator(y), std::make_move_iterator(y + n), load(pe) + e);
+				destroy(_a, y, y + n);
+				count += n;
+				set_end();
+			}
+			// The rest of its inner arrays are full from their beginning, so they swap with the free ones after the end
+			size_type k = (b + count) / SIZET;
+			for(size_type t = (n != 0); n < that.count && t <= (that.b + that.count - 1) / SIZET; ++t, ++k)
+				std::swap(*block(k), *that.block(t));
+			count += that.count - n;
+			set_end();
+			that.count = 0;
+			that.set_end();
+			assert(valid());
+			return;
+		}
+		if(that.count > count && adoptable(that))
+		{
+			that.prepend(std::move(*this));
+			swap(that);
+			// swap exchanges the growth policies and biases too, so give each container its own back
+			std::swap(growth, that.growth);
+			std::swap(bias, that.bias);
+			return;
+		}
+		if(that.empty())
+			return;
+		if(cb == nullptr || b + count + that.count > capacity())
+			rebuild(count + that.count);
+		that.for_each_segment(0, that.count, [this] (pointer x, pointer y)
+		{
+			while(x != y)
+			{
+				size_type k = std::min<size_type>(y - x, SIZET - e);
+				uninitialized_copy(_a, std::make_move_iterator(x), std::make_move_iterator(x + k), load(pe) + e);
+				count += k;
+				set_end();
+				x += k;
+			}
+		});
+		that.clear();
+		assert(valid());
+	}
+
 	// --
 	// at
 	// --
@@ -1071,6 +1944,39 @@ public:
 		return const_iterator(this, 0);
 	}
 
+	// -----------
+	// block_nodes
+	// -----------
+
+	/**
+	* Find the NUMA node of each inner array of the MyDeque container, for placement with a Numa_Allocator
+	* @return the node of the first element of each inner array in use, or -1 where the system does not support NUMA policies
+	*/
+	std::vector<int> block_nodes () const
+	{
+		std::vector<int> v;
+		for(size_type i = 0; i < count; i += SIZET - (b + i) % SIZET)
+			v.push_back(numa::node(&(*this)[i]));
+		return v;
+	}
+
+	// -----------
+	// commit_back
+	// -----------
+
+	/**
+	* Add the first k elements of the raw memory returned by grow_back_uninitialized to the end of the MyDeque container
+	* @param k - the # of elements that were written, at most the n passed to grow_back_uninitialized
+	*/
+	void commit_back (size_type k)
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "commit_back requires a trivially copyable type");
+		assert(k == 0 || b + count + k <= capacity());
+		count += k;
+		set_end();
+		assert(valid());
+	}
+
 	// -----
 	// clear
 	// -----
@@ -1085,6 +1991,58 @@ public:
 		assert(valid());
 	}
 
+	// -----------
+	// deserialize
+	// -----------
+
+	/**
+	* Replace the content of the MyDeque container with the elements written by serialize
+	* The elements are read straight into the inner arrays without constructing them
+	* @param in - an input stream
+	* @throws runtime_error exception if the stream does not hold a serialized MyDeque of the same element type and inner array
+	* length
+	* @throws length_error exception if a fixed capacity container is too small
+	*/
+	void deserialize (std::istream& in)
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "deserialize requires a trivially copyable type");
+		uint64_t h[4];
+		if(!in.read(reinterpret_cast<char*>(h), sizeof(h)) || h[1] != USIZET || h[2] >= USIZET || h[3] != sizeof(value_type))
+			throw std::runtime_error("deque::deserialize");
+		prepare(h[0], h[2]);
+		while(count != h[0])
+		{
+			size_type n = std::min<size_type>(SIZET - e, h[0] - count);
+			if(!in.read(reinterpret_cast<char*>(&(*this)[count]), n * sizeof(value_type)))
+				throw std::runtime_error("deque::deserialize");
+			count += n;
+			set_end();
+		}
+		assert(valid());
+	}
+
+	/**
+	* Replace the content of the MyDeque container with the elements written by serialize
+	* The elements are read straight into the inner arrays with readv, without constructing them
+	* @param fd - a file descriptor
+	* @throws system_error exception if a read fails
+	* @throws runtime_error exception if the file does not hold a serialized MyDeque of the same element type and inner array
+	* length
+	* @throws length_error exception if a fixed capacity container is too small
+	*/
+	void deserialize (int fd)
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "deserialize requires a trivially copyable type");
+		uint64_t h[4];
+		iovec x = {h, sizeof(h)};
+		transfer(fd, &x, 1, false);
+		if(h[1] != USIZET || h[2] >= USIZET || h[3] != sizeof(value_type))
+			throw std::runtime_error("deque::deserialize");
+		prepare(h[0], h[2]);
+		ia_transfer(fd, 0, h[0], false);
+		assert(valid());
+	}
+
 	// -----
 	// empty
 	// -----
@@ -1129,6 +2087,7 @@ public:
 	*/
 	iterator erase (iterator iter) 
 	{
+		DEQUE_TIME(erase);
 		if(count < 1)
 			return this->begin();
 		--count;
@@ -1138,13 +2097,82 @@ public:
 		while(lhs != this->end())
 		{
 			std::swap(*rhs, *lhs);
+			DEQUE_COUNT(shifted_elements, 1);
 			++lhs;
 			++rhs;
 		}
+		set_end();
 		assert(valid());
 		return iter;
 	}
 
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array
+	* The next inner array is prefetched before the function scans the current one
+	* @tparam F - a function object taking a pointer to the beginning and a pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f)
+	{
+		assert(i <= j && j <= count);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, j - i);
+			pointer x = &(*this)[i];
+			if(i + n < j)
+				prefetch_block((b + i) / SIZET + 1, false);
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array
+	* The next inner array is prefetched before the function scans the current one
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j && j <= count);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, j - i);
+			const_pointer x = &(*this)[i];
+			if(i + n < j)
+				prefetch_block((b + i) / SIZET + 1, false);
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	// ----
+	// full
+	// ----
+
+	/**
+	* Test whether a fixed capacity MyDeque container is full
+	* @return true if the MyDeque container has a fixed capacity and contains that many elements
+	*/
+	bool full () const
+	{
+		return limit != 0 && count == limit;
+	}
+
 	// -----
 	// front
 	// -----
@@ -1168,6 +2196,30 @@ public:
 		return const_cast<MyDeque*>(this)->front();
 	}
 
+	// -----------------------
+	// grow_back_uninitialized
+	// -----------------------
+
+	/**
+	* Make room for n elements past the end of the MyDeque container without constructing them, so that read, readv or recv
+	* can fill the inner arrays in place; commit_back then adds the elements that were written
+	* @param n - the # of elements
+	* @return the segments of the raw memory, one per inner array, which stay valid until the container is modified
+	* @throws length_error exception if a fixed capacity container cannot hold n more elements
+	* @throws logic_error exception if the container has a memory budget, whose inner arrays may be spilled
+	*/
+	segment_view<MyDeque, pointer> grow_back_uninitialized (size_type n)
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "grow_back_uninitialized requires a trivially copyable type");
+		if(limit != 0 && count + n > limit)
+			throw std::length_error("deque::grow_back_uninitialized");
+		if(spill != nullptr)
+			throw std::logic_error("deque::grow_back_uninitialized");
+		if(n != 0 && (cb == nullptr || b + count + n > capacity()))
+			rebuild(count + n);
+		return segment_view<MyDeque, pointer>(this, count, count + n);
+	}
+
 	// ------
 	// insert
 	// ------
@@ -1180,29 +2232,24 @@ public:
 	*/
 	iterator insert (iterator iter, const_reference v) 
 	{
-		if(cb == nullptr || (e == 0 && pe == ce))
+		DEQUE_TIME(insert);
+		if(full())
+			throw std::length_error("deque::insert");
+		if(cb == nullptr || b + count + 1 > capacity())
 			rebuild(this->size() + 1);
 
-		size_type ia_remain = SIZET - e;
-		if(ia_remain == 1)
-		{
-			++pe;
-			e = 0;
-		}
-		else
-		{
-			++e;
-		}
 		uninitialized_fill(_a, this->end(), this->end() + 1, v);
 		iterator lhs = this->end();
 		iterator rhs = this->end() - 1;
 		while(lhs != iter)
 		{
 			std::swap(*lhs, *rhs);
+			DEQUE_COUNT(shifted_elements, 1);
 			--lhs;
 			--rhs;
 		}
 		++count;
+		set_end();
 		assert(valid());
 		return iter;
 	}
@@ -1216,6 +2263,7 @@ public:
 	*/
 	void pop_back () 
 	{
+		DEQUE_TIME(pop_back);
 		assert(!empty());
 		resize(size() - 1);
 		assert(valid());
@@ -1226,14 +2274,137 @@ public:
 	*/
 	void pop_front () 
 	{
+		DEQUE_TIME(pop_front);
 		destroy(_a, this->begin(), this->begin() + 1);
-		++b;
-		if(b == SIZET && count != 1)
+		drop_front(1);
+		assert(valid());
+	}
+
+	/**
+	* Move the last n elements of the MyDeque container to an output iterator, in order, and delete them
+	* The elements are moved one inner array at a time
+	* @param n - the # of elements, at most size()
+	* @param out - an output iterator
+	* @return the output iterator past the last moved element
+	*/
+	template <typename OI>
+	OI pop_back_n (size_type n, OI out)
+	{
+		assert(n <= count);
+		for_each_segment(count - n, count, [&out] (pointer x, pointer y)
 		{
-			++pb;
-			b = 0;
+			out = std::move(x, y, out);
+		});
+		resize(count - n);
+		assert(valid());
+		return out;
+	}
+
+	/**
+	* Move the first n elements of the MyDeque container to an output iterator, in order, and delete them
+	* The elements are moved and destroyed one inner array at a time
+	* @param n - the # of elements, at most size()
+	* @param out - an output iterator
+	* @return the output iterator past the last moved element
+	*/
+	template <typename OI>
+	OI pop_front_n (size_type n, OI out)
+	{
+		assert(n <= count);
+		while(n != 0)
+		{
+			size_type k = std::min<size_type>(n, SIZET - b);
+			pointer x = &(*this)[0];
+			out = std::move(x, x + k, out);
+			destroy(_a, x, x + k);
+			drop_front(k);
+			n -= k;
 		}
-		--count;
+		assert(valid());
+		return out;
+	}
+
+	// -------
+	// prepend
+	// -------
+
+	/**
+	* Move the elements of another MyDeque container to the front of this one, leaving the other one empty
+	* When the other container ends at the offset where this one starts, its inner arrays are taken over by pointer and at
+	* most one inner array of elements is moved into the first inner array of this one. Otherwise the inner arrays of the
+	* larger container are kept by pointer and only the elements of the smaller one are moved, because all inner arrays of
+	* a MyDeque container share the offset b of the first element.
+	* @param that - another MyDeque container
+	* @throws length_error exception if a fixed capacity container cannot hold the elements
+	*/
+	void prepend (MyDeque&& that)
+	{
+		assert(this != &that);
+		if(limit != 0 && count + that.count > limit)
+			throw std::length_error("deque::prepend");
+		if(!empty() && !that.empty() && that.e == b && adoptable(that))
+		{
+			if(count + that.count + 2 * SIZET > capacity())
+				rebuild(count + that.count + SIZET);
+			// The elements of the last inner array of the other container go to the same offsets of the first one of this one
+			size_type n = std::min<size_type>(b, that.count);
+			if(n != 0)
+			{
+				pointer y = &that[that.count - n];
+				uninitialized_copy(_a, std::make_move_iterator(y), std::make_move_iterator(y + n), load(pb) + (b - n));
+				destroy(_a, y, y + n);
+				b -= n;
+				count += n;
+			}
+			// The rest of its inner arrays are full to their end, so they swap with the free ones before the beginning
+			for(size_type t = (that.b + that.count - n) / SIZET; n < that.count && t != 0; --t)
+			{
+				pb = (pb == cb) ? ce - 1 : pb - 1;
+				std::swap(*pb, *that.block(t - 1));
+			}
+			if(n < that.count)
+				b = that.b;
+			count += that.count - n;
+			set_end();
+			that.count = 0;
+			that.set_end();
+			assert(valid());
+			return;
+		}
+		if(that.count > count && adoptable(that))
+		{
+			that.append(std::move(*this));
+			swap(that);
+			// swap exchanges the growth policies and biases too, so give each container its own back
+			std::swap(growth, that.growth);
+			std::swap(bias, that.bias);
+			return;
+		}
+		if(that.empty())
+			return;
+		// Leave room for the new first inner array, which may wrap around to ce
+		if(limit == 0 && (cb == nullptr || count + that.count + 2 * SIZET > capacity()))
+			rebuild(count + that.count + SIZET);
+		// Move the elements from the back of the other container, as many at a time as fit in both inner arrays
+		for(size_type j = that.count; j != 0; )
+		{
+			pointer* x = pb;
+			size_type o = b;
+			if(o == 0)
+			{
+				x = (pb == cb) ? ce - 1 : pb - 1;
+				o = SIZET;
+			}
+			size_type k = std::min<size_type>(std::min<size_type>(j, o), (that.b + j - 1) % SIZET + 1);
+			pointer y = &that[j - k];
+			uninitialized_copy(_a, std::make_move_iterator(y), std::make_move_iterator(y + k), load(x) + (o - k));
+			pb = x;
+			b = o - k;
+			count += k;
+			j -= k;
+		}
+		set_end();
+		that.clear();
 		assert(valid());
 	}
 
@@ -1243,28 +2414,51 @@ public:
 
 	/**
 	* Add element to the end of the MyDeque container
+	* A full fixed capacity container removes the element at the opposite end if its overflow policy is overwrite
 	* @param v - a const reference to the value of the new element
+	* @throws length_error exception if a fixed capacity container is full and its overflow policy is reject
 	*/
 	void push_back (const_reference v) 
 	{
+		DEQUE_TIME(push_back);
+		if(full())
+		{
+			value_type x(v);
+			overflow(false);
+			push_back(x);
+			return;
+		}
+		++bias;
 		resize(this->size() + 1, v);
 		assert(valid());
 	}
 
 	/**
 	* Add element to the front of the MyDeque container
+	* A full fixed capacity container removes the element at the opposite end if its overflow policy is overwrite
 	* @param v - a const reference to the value of the new element
+	* @throws length_error exception if a fixed capacity container is full and its overflow policy is reject
 	*/
 	void push_front (const_reference v) 
 	{
-		// Check capacity
-		if(cb == nullptr || (cb == pb && b == 0))
+		DEQUE_TIME(push_front);
+		if(full())
+		{
+			value_type x(v);
+			overflow(true);
+			push_front(x);
+			return;
+		}
+		--bias;
+
+		// Check capacity - a new inner array is needed at the front, which may wrap around to ce
+		if(cb == nullptr || (b == 0 && count + SIZET > capacity()))
 			rebuild(this->size() + 1);
 
 		int ia_remain = b;
 		if(ia_remain == 0)
 		{
-			--pb;
+			pb = (pb == cb) ? ce - 1 : pb - 1;
 			b = SIZET - 1;
 		}
 		else
@@ -1276,6 +2470,72 @@ public:
 		assert(valid());
 	}
 
+	// ---------
+	// push_bias
+	// ---------
+
+	/**
+	* @return the # of push_back calls minus the # of push_front calls, inherited by copies, which a copy uses to put the free
+	* part of a partially filled inner array at the end the container grows
+	*/
+	difference_type push_bias () const
+	{
+		return bias;
+	}
+
+	// --------
+	// try_push
+	// --------
+
+	/**
+	* Add element to the end of the MyDeque container unless a fixed capacity container is full and rejects new elements
+	* @param v - a const reference to the value of the new element
+	* @return false if the element was not added
+	*/
+	bool try_push_back (const_reference v)
+	{
+		if(full() && policy == reject)
+			return false;
+		push_back(v);
+		return true;
+	}
+
+	/**
+	* Add element to the front of the MyDeque container unless a fixed capacity container is full and rejects new elements
+	* @param v - a const reference to the value of the new element
+	* @return false if the element was not added
+	*/
+	bool try_push_front (const_reference v)
+	{
+		if(full() && policy == reject)
+			return false;
+		push_front(v);
+		return true;
+	}
+
+	// -------
+	// recycle
+	// -------
+
+	/**
+	* Destroy the elements of a block_span and keep its inner array for the next take_front_block
+	* @param s - a block_span taken from a MyDeque container with an equal allocator, which becomes empty
+	*/
+	void recycle (block_span&& s)
+	{
+		if(s._p == nullptr)
+			return;
+		destroy(s._a, s._b, s._e);
+		if(spare == nullptr && s._a == _a)
+			spare = s._p;
+		else
+		{
+			s._a.deallocate(s._p, SIZET);
+			DEQUE_COUNT(block_frees, 1);
+		}
+		s._p = s._b = s._e = nullptr;
+	}
+
 	// ------
 	// resize
 	// ------
@@ -1290,53 +2550,43 @@ public:
 	*/
 	void resize (size_type s, const_reference v = value_type()) 
 	{
-		size_type add = s - this->size();
-		size_type capacity = (cb == nullptr) ? 0 : (ce - pe) * SIZET;
+		DEQUE_TIME(resize);
+		if (limit != 0 && s > limit)
+			throw std::length_error("deque::resize");
+		// capacity = the number of elements from the beginning to the wrap around point of the outer array
+		size_type capacity = (cb == nullptr) ? 0 : this->capacity() - b;
 		if (s == this->size())
 		{
 			return;
 		}
-		if (s < this->size())
+		if (s < this->size() && spill != nullptr)
+		{
+			// The elements are trivially destructible, so the inner arrays past the new end are freed without reading them back
+			size_type used = (b + count + SIZET - 1) / SIZET;
+			count = s;
+			set_end();
+			for(size_type i = (b + count + SIZET - 1) / SIZET; i < used; ++i)
+				unload(block(i));
+			for(size_type i = 1; i <= 3 && i * SIZET < b + count; ++i)
+				prefetch(block((b + count - 1) / SIZET - i));
+		}
+		else if (s < this->size())
 		{
-			size_type offsetBOA = pb - cb;
-			size_type outer_array_index = (s + b) / SIZET + offsetBOA;
-			size_type inner_array_index = (s + b) % SIZET;
-			pe = cb + outer_array_index;
-			e = inner_array_index;
-			size_type ia_remain = SIZET - e;
-			if(ia_remain == 0)
-			{
-				++pe;
-				e = 0;
-			}
 			destroy(_a, this->begin() + s, this->end());
 			count = s;
+			set_end();
 		}
-		else if (add <= capacity)
+		else if (s <= capacity)
 		{
-			size_type ia_remain = SIZET - e;
-			if(ia_remain != 0)
+			// Fill one inner array at a time, wrapping around at ce
+			while(count != s)
 			{
-				int fillsize = std::min(add, ia_remain);
-				uninitialized_fill(_a, *pe + e, *pe + e + fillsize, v);
-				e += fillsize;
-				add -= fillsize;
-				ia_remain -= fillsize;
+				size_type fillsize = std::min<size_type>(s - count, SIZET - e);
+				pointer x = load(pe);
+				uninitialized_fill(_a, x + e, x + e + fillsize, v);
+				count += fillsize;
+				set_end();
 			}
-
-			if(ia_remain == 0)
-			{
-				++pe;
-				e = 0;
-			}
-
-			if(add != 0)
-			{
-				ia_fill(add, v, pe);
-				++pe;
-			}
-
-			count = s;
 		}
 		else 
 		{
@@ -1346,6 +2596,239 @@ public:
 		assert(valid());
 	}
 
+	// --------
+	// segments
+	// --------
+
+	/**
+	* @param first - an iterator to the first element of a range
+	* @param last - an iterator past the last element of the range
+	* @return the contiguous segments of the range, one per inner array
+	*/
+	segment_view<MyDeque, pointer> segments (iterator first, iterator last)
+	{
+		return segment_view<MyDeque, pointer>(this, first.index(), last.index());
+	}
+
+	/**
+	* @param first - a const iterator to the first element of a range
+	* @param last - a const iterator past the last element of the range
+	* @return the contiguous segments of the range, one per inner array
+	*/
+	segment_view<const MyDeque, const_pointer> segments (const_iterator first, const_iterator last) const
+	{
+		return segment_view<const MyDeque, const_pointer>(this, first.index(), last.index());
+	}
+
+	/**
+	* @return the contiguous segments of the MyDeque container, one per inner array
+	*/
+	segment_view<const MyDeque, const_pointer> segments () const
+	{
+		return segments(begin(), end());
+	}
+
+	// ---------
+	// serialize
+	// ---------
+
+	/**
+	* Write the MyDeque container as a header followed by the live range of each inner array
+	* The header holds the size, the length of an inner array, the front offset b and the size of an element
+	* @param out - an output stream
+	*/
+	void serialize (std::ostream& out) const
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "serialize requires a trivially copyable type");
+		uint64_t h[4] = {count, USIZET, static_cast<uint64_t>(b), sizeof(value_type)};
+		out.write(reinterpret_cast<const char*>(h), sizeof(h));
+		for(size_type i = 0; i != count; )
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, count - i);
+			out.write(reinterpret_cast<const char*>(&(*this)[i]), n * sizeof(value_type));
+			i += n;
+		}
+	}
+
+	/**
+	* Write the MyDeque container as a header followed by the live range of each inner array, gathered with writev
+	* The header holds the size, the length of an inner array, the front offset b and the size of an element
+	* @param fd - a file descriptor
+	* @throws system_error exception if a write fails
+	*/
+	void serialize (int fd) const
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "serialize requires a trivially copyable type");
+		uint64_t h[4] = {count, USIZET, static_cast<uint64_t>(b), sizeof(value_type)};
+		iovec x = {h, sizeof(h)};
+		transfer(fd, &x, 1, true);
+		const_cast<MyDeque*>(this)->ia_transfer(fd, 0, count, true);
+	}
+
+	// -----------------
+	// set_growth_policy
+	// -----------------
+
+	/**
+	* Change how the MyDeque container grows its outer array from the next rebuild on, and the headroom of its later copies
+	* @param g - the growth policy
+	* @throws invalid_argument exception if the growth factor is less than 1
+	*/
+	void set_growth_policy (const growth_policy& g)
+	{
+		if(!(g.factor >= 1))
+			throw std::invalid_argument("deque::set_growth_policy");
+		growth = g;
+	}
+
+	// -----------------
+	// set_memory_budget
+	// -----------------
+
+	/**
+	* Keep the inner arrays of the MyDeque container within a memory budget
+	* When the budget is exceeded, inner arrays away from both ends are written to a spill file,
+	* and they are read back on another thread as the front or back approaches them.
+	* The budget cannot be changed or removed; a copy of the container has no memory budget.
+	* Reading an element may read its inner array back, so threads must not read the container concurrently, even through
+	* const members.
+	* The PINNED inner arrays accessed last are never spilled, so a reference to an element stays valid until elements of
+	* PINNED other inner arrays have been accessed or the container is modified; they may exceed the budget.
+	* @param bytes - the memory budget, which is at least eight inner arrays
+	* @param path - the path of the spill file, which is unlinked as soon as it is created
+	* @throws system_error exception if the spill file cannot be created
+	*/
+	void set_memory_budget (size_type bytes, const char* path)
+	{
+		static_assert(std::is_trivially_copyable<value_type>::value, "a memory budget requires a trivially copyable type");
+		assert(spill == nullptr && limit == 0);
+		size_type blocks = std::max<size_type>(bytes / (SIZET * sizeof(value_type)), 8);
+		spill = new spill_type(path, _a, SIZET, SIZET * sizeof(value_type), blocks);
+		if(cb == nullptr)
+			return;
+		// Free the inner arrays that are not in use
+		size_type used = (b + count + SIZET - 1) / SIZET;
+		for(size_type i = used; i < static_cast<size_type>(ce - cb); ++i)
+		{
+			_a.deallocate(*block(i), SIZET);
+			DEQUE_COUNT(block_frees, 1);
+			*block(i) = nullptr;
+		}
+		spill->resident(used);
+		shed(-2);
+		assert(valid());
+	}
+
+	// -----------
+	// spill_stats
+	// -----------
+
+	/**
+	* @return the counters of the spill file, which are zero if the MyDeque container has no memory budget
+	*/
+	SpillStats spill_stats () const
+	{
+		return (spill == nullptr) ? SpillStats() : spill->stats();
+	}
+
+	// ---------
+	// split_off
+	// ---------
+
+	/**
+	* Move the elements [pos, end()) to a new MyDeque container
+	* The new container takes the inner arrays past pos by pointer; only the smaller part of the inner array holding pos is moved
+	* to a new inner array. A container with a memory budget or a fixed capacity moves every element instead.
+	* @param pos - an iterator to the first element to move
+	* @return a MyDeque container with the elements from pos on
+	*/
+	MyDeque split_off (iterator pos)
+	{
+		size_type i = pos.index();
+		assert(i <= count);
+		MyDeque x(_a);
+		if(i == count)
+			return x;
+		if(limit != 0 || spill != nullptr)
+		{
+			x.place(count - i);
+			x.copy_back(count - i, std::make_move_iterator(begin() + i));
+			resize(i);
+			return x;
+		}
+		if(i == 0)
+		{
+			x.swap(*this);
+			return x;
+		}
+		size_type outer = ce - cb;
+		size_type k = (b + i) / SIZET;                   // the inner array holding pos
+		size_type o = (b + i) % SIZET;                   // the offset of pos in it
+		size_type used = (b + count + SIZET - 1) / SIZET;
+		size_type head = (o != 0) ? k + 1 : k;           // # of inner arrays this container keeps
+		if(o != 0)
+		{
+			// Move the smaller part of the shared inner array to a new one, which goes to the container that part belongs to
+			pointer y = *block(k);
+			pointer z = _a.allocate(SIZET);
+			DEQUE_COUNT(block_allocations, 1);
+			size_type lo = (k == 0) ? b : 0;
+			size_type hi = std::min<size_type>(SIZET, b + count - k * SIZET);
+			size_type from = (o - lo <= hi - o) ? lo : o;
+			size_type to = (o - lo <= hi - o) ? o : hi;
+			uninitialized_copy(_a, std::make_move_iterator(y + from), std::make_move_iterator(y + to), z + from);
+			destroy(_a, y + from, y + to);
+			DEQUE_COUNT(shifted_elements, to - from);
+			if(from == lo)
+				*block(k) = z;
+			else
+				y = z;
+			x.cb = x._astar.allocate(used - k);
+			x.cb[0] = y;
+		}
+		else
+			x.cb = x._astar.allocate(used - k);
+		for(size_type j = (o != 0) ? k + 1 : k; j != used; ++j)
+			x.cb[j - k] = *block(j);
+		x.ce = x.cb + (used - k);
+		x.pb = x.cb;
+		x.b = o;
+		x.count = count - i;
+		x.set_end();
+		// Keep the inner arrays in use followed by the unused ones; pos is not the first element, so head is at least one
+		size_type n = outer - (used - head);
+		pointer* c = _astar.allocate(n);
+		for(size_type j = 0; j != head; ++j)
+			c[j] = *block(j);
+		for(size_type j = used; j != outer; ++j)
+			c[head + (j - used)] = *block(j);
+		_astar.deallocate(cb, outer);
+		cb = pb = c;
+		ce = c + n;
+		count = i;
+		set_end();
+		assert(valid());
+		assert(x.valid());
+		return x;
+	}
+
+	// -----
+	// stats
+	// -----
+
+	/**
+	* @return the instrumentation counters of the MyDeque container, which are zero unless it is compiled with -DDEQUE_STATS;
+	* DequeStatsRegistry holds the totals of each MyDeque type
+	*/
+	DequeStats stats () const
+	{
+		#ifdef DEQUE_STATS
+		return *_sink;
+		#else
+		return DequeStats();
+		#endif
+	}
+
 	// ----
 	// size
 	// ----
@@ -1377,6 +2860,14 @@ public:
 			std::swap(b, that.b);
 			std::swap(e, that.e);
 			std::swap(count, that.count);
+			std::swap(policy, that.policy);
+			std::swap(limit, that.limit);
+			std::swap(spill, that.spill);
+			std::swap(spare, that.spare);
+			std::swap(growth, that.growth);
+			std::swap(bias, that.bias);
+			std::swap_ranges(pins, pins + PINNED, that.pins);
+			std::swap(pin, that.pin);
 		}
 		else 
 		{
@@ -1386,6 +2877,47 @@ public:
 		}
 		assert(valid());
 	}
+
+	// ----------------
+	// take_front_block
+	// ----------------
+
+	/**
+	* Detach the elements of the first inner array of the MyDeque container without copying them
+	* The outer array slot gets the inner array given back by recycle, or a new one.
+	* A MyDeque container with a memory budget moves the elements to a new inner array instead, because its inner arrays
+	* belong to its spill file.
+	* A fixed capacity MyDeque container never allocates after construction, so it needs an inner array given back by recycle.
+	* @return a block_span that owns the elements, which is empty if the container is empty
+	* @throws length_error exception if the container is fixed capacity and recycle has not given back an inner array
+	*/
+	block_span take_front_block ()
+	{
+		size_type n = std::min<size_type>(count, SIZET - b);
+		if(n == 0)
+			return block_span();
+		if(limit != 0 && spare == nullptr)
+			throw std::length_error("deque::take_front_block");
+		pointer p = spare;
+		spare = nullptr;
+		if(p == nullptr)
+		{
+			p = _a.allocate(SIZET);
+			DEQUE_COUNT(block_allocations, 1);
+		}
+		if(spill != nullptr)
+		{
+			pointer x = &(*this)[0];
+			std::uninitialized_copy(std::make_move_iterator(x), std::make_move_iterator(x + n), p + b);
+			destroy(_a, x, x + n);
+		}
+		else
+			std::swap(p, *pb);
+		block_span s(_a, p, p + b, p + b + n);
+		drop_front(n);
+		assert(valid());
+		return s;
+	}
 };
 
 #endif // Deque_h
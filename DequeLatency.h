@@ -0,0 +1,383 @@
+// --------------
+// DequeLatency.h
+// --------------
+
+#ifndef DequeLatency_h
+#define DequeLatency_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // min
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdlib>  // free
+#include <list>     // list
+#include <mutex>    // lock_guard, mutex
+#include <ostream>  // ostream
+#include <stdint.h> // uint64_t
+#include <string>   // string
+#include <typeinfo> // type_info
+#include <utility>  // pair
+
+#if defined(__GNUC__)
+#include <cxxabi.h> // __cxa_demangle
+#endif
+
+// ----------------
+// LatencyHistogram
+// ----------------
+
+///
+/// A log-linear histogram of latencies in nanoseconds, in the style of HdrHistogram
+/// Values below 2^sub_bits have a bucket each; above that, every power of two is split into 2^sub_bits buckets,
+/// so a percentile is within 1 / 2^sub_bits of the true value. Recording is a relaxed atomic increment.
+///
+class LatencyHistogram
+{
+public:
+	static const int sub_bits = 4;
+	static const std::size_t buckets = (65 - sub_bits) << sub_bits;
+
+private:
+	// ----
+	// data
+	// ----
+
+	std::size_t counts[buckets];
+	uint64_t _max;
+
+public:
+	// ------
+	// bucket
+	// ------
+
+	/**
+	* @param v - a value
+	* @return the bucket of the value
+	*/
+	static std::size_t bucket (uint64_t v)
+	{
+		if(v < (1U << sub_bits))
+			return v;
+		int shift = 63 - __builtin_clzll(v) - sub_bits;
+		return ((shift + 1) << sub_bits) + ((v >> shift) & ((1U << sub_bits) - 1));
+	}
+
+	/**
+	* @param i - a bucket
+	* @return the largest value of the bucket
+	*/
+	static uint64_t highest (std::size_t i)
+	{
+		if(i < (1U << sub_bits))
+			return i;
+		int shift = (i >> sub_bits) - 1;
+		uint64_t lo = static_cast<uint64_t>((1U << sub_bits) | (i & ((1U << sub_bits) - 1))) << shift;
+		return lo + ((static_cast<uint64_t>(1) << shift) - 1);
+	}
+
+	// ------------
+	// constructors
+	// ------------
+
+	LatencyHistogram ()
+	{
+		reset();
+	}
+
+	// ------
+	// record
+	// ------
+
+	/**
+	* Record a latency from any thread
+	* @param ns - the latency in nanoseconds
+	*/
+	void record (uint64_t ns)
+	{
+		__atomic_fetch_add(&counts[bucket(ns)], 1, __ATOMIC_RELAXED);
+		uint64_t m = __atomic_load_n(&_max, __ATOMIC_RELAXED);
+		while(ns > m && !__atomic_compare_exchange_n(&_max, &m, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{}
+	}
+
+	// -----
+	// count
+	// -----
+
+	/**
+	* @return the # of recorded latencies
+	*/
+	std::size_t count () const
+	{
+		std::size_t n = 0;
+		for(std::size_t i = 0; i != buckets; ++i)
+			n += __atomic_load_n(&counts[i], __ATOMIC_RELAXED);
+		return n;
+	}
+
+	// ---
+	// max
+	// ---
+
+	/**
+	* @return the largest recorded latency
+	*/
+	uint64_t max () const
+	{
+		return __atomic_load_n(&_max, __ATOMIC_RELAXED);
+	}
+
+	// ----------
+	// percentile
+	// ----------
+
+	/**
+	* @param p - a percentile in [0, 100]
+	* @return the largest value of the bucket holding the p-th percentile latency, and at most max(), or 0 if none was recorded
+	*/
+	uint64_t percentile (double p) const
+	{
+		std::size_t n = count();
+		if(n == 0)
+			return 0;
+		std::size_t rank = static_cast<std::size_t>(p / 100 * n + 0.5);
+		if(rank == 0)
+			rank = 1;
+		std::size_t seen = 0;
+		for(std::size_t i = 0; i != buckets; ++i)
+		{
+			seen += __atomic_load_n(&counts[i], __ATOMIC_RELAXED);
+			if(seen >= rank)
+				return std::min(highest(i), max());
+		}
+		return max();
+	}
+
+	// -----
+	// reset
+	// -----
+
+	/**
+	* Forget every recorded latency
+	*/
+	void reset ()
+	{
+		for(std::size_t i = 0; i != buckets; ++i)
+			__atomic_store_n(&counts[i], 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&_max, 0, __ATOMIC_RELAXED);
+	}
+};
+
+// ------------
+// DequeLatency
+// ------------
+
+///
+/// The latency histograms of the mutators of a MyDeque type
+/// A MyDeque container records them only when it is compiled with -DDEQUE_LATENCY.
+/// The flag changes the inline members of MyDeque, so every translation unit of a program must be compiled with it or without it.
+///
+struct DequeLatency
+{
+	enum operation { push_back, push_front, pop_back, pop_front, insert, erase, resize, assign, operations };
+
+	LatencyHistogram histograms[operations];
+
+	/**
+	* @param op - an operation
+	* @return the name of the operation
+	*/
+	static const char* name (int op)
+	{
+		static const char* const names[operations] = {"push_back", "push_front", "pop_back", "pop_front", "insert", "erase", "resize", "operator="};
+		return names[op];
+	}
+};
+
+// --------------------
+// DequeLatencyRegistry
+// --------------------
+
+///
+/// The latency histograms of every MyDeque type compiled with -DDEQUE_LATENCY, and how often they sample
+///
+class DequeLatencyRegistry
+{
+private:
+	// ----
+	// data
+	// ----
+
+	mutable std::mutex m;
+	std::list<std::pair<std::string, DequeLatency> > entries;
+	unsigned period;
+
+	DequeLatencyRegistry () : period (1)
+	{}
+
+public:
+	DequeLatencyRegistry (const DequeLatencyRegistry&) = delete;
+	DequeLatencyRegistry& operator = (const DequeLatencyRegistry&) = delete;
+
+	/**
+	* @return the registry shared by every MyDeque type
+	*/
+	static DequeLatencyRegistry& instance ()
+	{
+		static DequeLatencyRegistry x;
+		return x;
+	}
+
+	// ---
+	// add
+	// ---
+
+	/**
+	* Register the histograms of a type
+	* @param t - the type
+	* @return its histograms, which stay at the same address for the life of the program
+	*/
+	DequeLatency& add (const std::type_info& t)
+	{
+		std::string name = t.name();
+		#if defined(__GNUC__)
+		int status = 0;
+		char* s = abi::__cxa_demangle(t.name(), nullptr, nullptr, &status);
+		if(status == 0)
+			name = s;
+		std::free(s);
+		#endif
+		std::lock_guard<std::mutex> lock(m);
+		entries.push_back(std::make_pair(name, DequeLatency()));
+		return entries.back().second;
+	}
+
+	// --------
+	// sampling
+	// --------
+
+	/**
+	* Time one in every n operations of each thread
+	* @param n - the sampling period, where 1 times every operation
+	*/
+	void sample_every (unsigned n)
+	{
+		__atomic_store_n(&period, (n == 0) ? 1 : n, __ATOMIC_RELAXED);
+	}
+
+	/**
+	* @return true if the calling thread should time its next operation
+	*/
+	bool sample ()
+	{
+		static thread_local unsigned tick = 0;
+		unsigned n = __atomic_load_n(&period, __ATOMIC_RELAXED);
+		return n == 1 || ++tick % n == 0;
+	}
+
+	// -----
+	// reset
+	// -----
+
+	/**
+	* Forget every recorded latency of every type
+	*/
+	void reset ()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		for(std::list<std::pair<std::string, DequeLatency> >::iterator i = entries.begin(); i != entries.end(); ++i)
+			for(int op = 0; op != DequeLatency::operations; ++op)
+				i->second.histograms[op].reset();
+	}
+
+	// ------
+	// scrape
+	// ------
+
+	/**
+	* Call a function with the histogram of each operation of each registered type
+	* @tparam F - a function object taking the name of the type, the name of the operation and its LatencyHistogram
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F scrape (F f) const
+	{
+		std::lock_guard<std::mutex> lock(m);
+		for(std::list<std::pair<std::string, DequeLatency> >::const_iterator i = entries.begin(); i != entries.end(); ++i)
+			for(int op = 0; op != DequeLatency::operations; ++op)
+				f(i->first, DequeLatency::name(op), i->second.histograms[op]);
+		return f;
+	}
+
+	// ----
+	// dump
+	// ----
+
+	/**
+	* Print the count, p50, p99, p99.9 and max in nanoseconds of each operation that recorded a latency
+	* @param w - an ostream
+	* @return the ostream
+	*/
+	std::ostream& dump (std::ostream& w) const
+	{
+		scrape([&w] (const std::string& type, const char* op, const LatencyHistogram& h)
+		{
+			std::size_t n = h.count();
+			if(n != 0)
+				w << type << "\t" << op << "\tcount " << n << "\tp50 " << h.percentile(50) << "\tp99 " << h.percentile(99)
+				  << "\tp99.9 " << h.percentile(99.9) << "\tmax " << h.max() << " ns\n";
+		});
+		return w;
+	}
+};
+
+// ----------
+// DequeTimer
+// ----------
+
+///
+/// Times an operation of a MyDeque container from construction to destruction
+/// Only the outermost timed operation of a thread is recorded, so push_back does not also record the resize it calls.
+///
+class DequeTimer
+{
+private:
+	LatencyHistogram* h;
+	std::chrono::steady_clock::time_point t;
+
+	static int& depth ()
+	{
+		static thread_local int d = 0;
+		return d;
+	}
+
+public:
+	/**
+	* @param x - the histograms of a MyDeque type
+	* @param op - the DequeLatency operation being timed
+	*/
+	DequeTimer (DequeLatency& x, int op) : h (nullptr)
+	{
+		if(depth()++ == 0 && DequeLatencyRegistry::instance().sample())
+		{
+			h = &x.histograms[op];
+			t = std::chrono::steady_clock::now();
+		}
+	}
+
+	DequeTimer (const DequeTimer&) = delete;
+	DequeTimer& operator = (const DequeTimer&) = delete;
+
+	~DequeTimer ()
+	{
+		if(h != nullptr)
+			h->record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t).count());
+		--depth();
+	}
+};
+
+#endif // DequeLatency_h
@@ -0,0 +1,166 @@
+// ------------
+// DequeStats.h
+// ------------
+
+#ifndef DequeStats_h
+#define DequeStats_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef>  // size_t
+#include <cstdlib>  // free
+#include <list>     // list
+#include <mutex>    // lock_guard, mutex
+#include <string>   // string
+#include <typeinfo> // type_info
+#include <utility>  // pair
+
+#if defined(__GNUC__)
+#include <cxxabi.h> // __cxa_demangle
+#endif
+
+// ----------
+// DequeStats
+// ----------
+
+///
+/// Counters of the events that make a MyDeque container slow
+/// A MyDeque container counts them only when it is compiled with -DDEQUE_STATS.
+/// The flag changes the layout of MyDeque, so every translation unit of a program must be compiled with it or without it.
+///
+struct DequeStats
+{
+	std::size_t rebuilds;          // # of times the outer array was rebuilt
+	std::size_t rebuilt_elements;  // # of elements moved into a rebuilt outer array
+	std::size_t block_allocations; // # of inner arrays allocated
+	std::size_t block_frees;       // # of inner arrays freed
+	std::size_t shifted_elements;  // # of elements moved by insert and erase
+	std::size_t subscripts;        // # of calls to operator []
+};
+
+// ------------------
+// DequeStatsRegistry
+// ------------------
+
+///
+/// The counters of every instrumented MyDeque type, which a metrics exporter can scrape
+/// Each MyDeque type registers its counters the first time it counts an event, and adds to them with relaxed atomics.
+///
+class DequeStatsRegistry
+{
+private:
+	// ----
+	// data
+	// ----
+
+	mutable std::mutex m;
+	std::list<std::pair<std::string, DequeStats> > entries;
+
+	DequeStatsRegistry ()
+	{}
+
+public:
+	DequeStatsRegistry (const DequeStatsRegistry&) = delete;
+	DequeStatsRegistry& operator = (const DequeStatsRegistry&) = delete;
+
+	/**
+	* @return the registry shared by every MyDeque type
+	*/
+	static DequeStatsRegistry& instance ()
+	{
+		static DequeStatsRegistry x;
+		return x;
+	}
+
+	// ---
+	// add
+	// ---
+
+	/**
+	* Register the counters of a type
+	* @param t - the type
+	* @return its counters, which stay at the same address for the life of the program
+	*/
+	DequeStats& add (const std::type_info& t)
+	{
+		std::string name = t.name();
+		#if defined(__GNUC__)
+		int status = 0;
+		char* s = abi::__cxa_demangle(t.name(), nullptr, nullptr, &status);
+		if(status == 0)
+			name = s;
+		std::free(s);
+		#endif
+		std::lock_guard<std::mutex> lock(m);
+		entries.push_back(std::make_pair(name, DequeStats()));
+		return entries.back().second;
+	}
+
+	// -----
+	// count
+	// -----
+
+	/**
+	* Add to a counter from any thread
+	* @param x - the counters of a type
+	* @param c - the counter
+	* @param n - the # of events
+	*/
+	static void count (DequeStats& x, std::size_t DequeStats::* c, std::size_t n)
+	{
+		__atomic_fetch_add(&(x.*c), n, __ATOMIC_RELAXED);
+	}
+
+	// -----
+	// reset
+	// -----
+
+	/**
+	* Set every counter of every type to zero
+	*/
+	void reset ()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		for(std::list<std::pair<std::string, DequeStats> >::iterator i = entries.begin(); i != entries.end(); ++i)
+		{
+			__atomic_store_n(&i->second.rebuilds, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&i->second.rebuilt_elements, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&i->second.block_allocations, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&i->second.block_frees, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&i->second.shifted_elements, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&i->second.subscripts, 0, __ATOMIC_RELAXED);
+		}
+	}
+
+	// ------
+	// scrape
+	// ------
+
+	/**
+	* Call a function with a snapshot of the counters of each registered type
+	* @tparam F - a function object taking the name of the type and its DequeStats
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F scrape (F f) const
+	{
+		std::lock_guard<std::mutex> lock(m);
+		for(std::list<std::pair<std::string, DequeStats> >::const_iterator i = entries.begin(); i != entries.end(); ++i)
+		{
+			DequeStats x;
+			x.rebuilds = __atomic_load_n(&i->second.rebuilds, __ATOMIC_RELAXED);
+			x.rebuilt_elements = __atomic_load_n(&i->second.rebuilt_elements, __ATOMIC_RELAXED);
+			x.block_allocations = __atomic_load_n(&i->second.block_allocations, __ATOMIC_RELAXED);
+			x.block_frees = __atomic_load_n(&i->second.block_frees, __ATOMIC_RELAXED);
+			x.shifted_elements = __atomic_load_n(&i->second.shifted_elements, __ATOMIC_RELAXED);
+			x.subscripts = __atomic_load_n(&i->second.subscripts, __ATOMIC_RELAXED);
+			f(i->first, x);
+		}
+		return f;
+	}
+};
+
+#endif // DequeStats_h
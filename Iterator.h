@@ -0,0 +1,263 @@
+// ----------
+// Iterator.h
+// ----------
+
+#ifndef Iterator_h
+#define Iterator_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>  // assert
+#include <cstddef>  // ptrdiff_t, size_t
+#include <iterator> // bidirectional_iterator_tag
+
+// Functions that loop or modify their object can be constexpr only from C++14 on
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+#define DEQUE_CONSTEXPR14 constexpr
+#else
+#define DEQUE_CONSTEXPR14
+#endif
+
+// -------------
+// IndexIterator
+// -------------
+
+///
+/// A bidirectional iterator over any container that provides operator[] and size()
+/// The iterator stores a pointer to the container and an index, so it stays valid when the container moves its storage
+/// @tparam C - Type of the container, const qualified for a const iterator
+/// @tparam V - Type of the elements
+/// @tparam R - Type of a reference to an element
+/// @tparam P - Type of a pointer to an element
+///
+template <typename C, typename V, typename R, typename P>
+class IndexIterator
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef V                               value_type;
+	typedef std::ptrdiff_t                  difference_type;
+	typedef P                               pointer;
+	typedef R                               reference;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side IndexIterator
+	* @param rhs - the right hand side IndexIterator
+	* @return true if the lhs IndexIterator is equal to the rhs IndexIterator
+	*/
+	friend constexpr bool operator == (const IndexIterator& lhs, const IndexIterator& rhs)
+	{
+		return (lhs._p == rhs._p) && (lhs._index == rhs._index);
+	}
+
+	/**
+	* not equal operator
+	* @param lhs - the left hand side IndexIterator
+	* @param rhs - the right hand side IndexIterator
+	* @return true if the lhs IndexIterator is not equal to the rhs IndexIterator
+	*/
+	friend constexpr bool operator != (const IndexIterator& lhs, const IndexIterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// ----------
+	// operator +
+	// ----------
+
+	/**
+	* addition operator
+	* @param lhs - the left hand side IndexIterator
+	* @param rhs - the right hand side difference_type
+	* @return an IndexIterator shifted forward by the difference_type value
+	*/
+	friend DEQUE_CONSTEXPR14 IndexIterator operator + (IndexIterator lhs, difference_type rhs)
+	{
+		return lhs += rhs;
+	}
+
+	// ----------
+	// operator -
+	// ----------
+
+	/**
+	* subtraction operator
+	* @param lhs - the left hand side IndexIterator
+	* @param rhs - the right hand side difference_type
+	* @return an IndexIterator shifted backward by the difference_type value
+	*/
+	friend DEQUE_CONSTEXPR14 IndexIterator operator - (IndexIterator lhs, difference_type rhs)
+	{
+		return lhs -= rhs;
+	}
+
+private:
+	// ----
+	// data
+	// ----
+	C*          _p;
+	std::size_t _index;
+
+public:
+	// -----------
+	// constructor
+	// -----------
+
+	/**
+	* Create an IndexIterator object using a container
+	* @param p - a pointer to the container
+	* @param i - index state for the IndexIterator
+	*/
+	constexpr IndexIterator (C* p = nullptr, std::size_t i = 0) : _p(p), _index(i)
+	{}
+
+	/**
+	* Convert a modifiable IndexIterator to a const IndexIterator
+	* @param that - an IndexIterator over the same container type
+	*/
+	template <typename D, typename S, typename Q>
+	constexpr IndexIterator (const IndexIterator<D, V, S, Q>& that) : _p(that.container()), _index(that.index())
+	{}
+
+	// Default copy, destructor, and copy assignment.
+	// IndexIterator (const IndexIterator&);
+	// ~IndexIterator ();
+	// IndexIterator& operator = (const IndexIterator&);
+
+	/**
+	* @return a pointer to the container of the IndexIterator
+	*/
+	constexpr C* container () const
+	{
+		return _p;
+	}
+
+	/**
+	* @return the index of the IndexIterator
+	*/
+	constexpr std::size_t index () const
+	{
+		return _index;
+	}
+
+	// ----------
+	// operator *
+	// ----------
+
+	/**
+	* dereference operator
+	* @return a reference to the value in the IndexIterator's current state
+	*/
+	DEQUE_CONSTEXPR14 reference operator * () const
+	{
+		assert(_index <= _p->size());
+		return (*_p)[_index];
+	}
+
+	// -----------
+	// operator ->
+	// -----------
+
+	/**
+	* pointer member access operator
+	* @return a pointer to the value in the IndexIterator's current state
+	*/
+	pointer operator -> () const
+	{
+		return &**this;
+	}
+
+	// -----------
+	// operator ++
+	// -----------
+
+	/**
+	* Pre-increment Operator
+	* @return an IndexIterator reference incremented by 1
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator& operator ++ ()
+	{
+		++_index;
+		return *this;
+	}
+
+	/**
+	* Post-Increment Operator
+	* @return an IndexIterator incremented by 1
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator operator ++ (int)
+	{
+		IndexIterator x = *this;
+		++(*this);
+		return x;
+	}
+
+	// -----------
+	// operator --
+	// -----------
+
+	/**
+	* Pre-decrement Operator
+	* @return an IndexIterator reference decremented by 1
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator& operator -- ()
+	{
+		--_index;
+		return *this;
+	}
+
+	/**
+	* Post-Decrement Operator
+	* @return an IndexIterator decremented by 1
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator operator -- (int)
+	{
+		IndexIterator x = *this;
+		--(*this);
+		return x;
+	}
+
+	// -----------
+	// operator +=
+	// -----------
+
+	/**
+	* Addition Assignent Operator
+	* @param d - the right hand side difference_type
+	* @return an IndexIterator reference shifted forward by the difference_type value
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator& operator += (difference_type d)
+	{
+		_index += d;
+		return *this;
+	}
+
+	// -----------
+	// operator -=
+	// -----------
+
+	/**
+	* Subtraction Assignent Operator
+	* @param d - the right hand side difference_type
+	* @return an IndexIterator reference shifted backward by the difference_type value
+	*/
+	DEQUE_CONSTEXPR14 IndexIterator& operator -= (difference_type d)
+	{
+		_index -= d;
+		return *this;
+	}
+};
+
+#endif // Iterator_h
@@ -0,0 +1,309 @@
+// ----------
+// LogDeque.h
+// ----------
+
+#ifndef LogDeque_h
+#define LogDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // copy, fill, min
+#include <cassert>   // assert
+#include <cstddef>   // ptrdiff_t, size_t
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // out_of_range
+#include <utility>   // pair
+#include <vector>    // vector
+
+#include "Deque.h"    // SIZET, uninitialized_fill, destroy
+#include "Iterator.h" // IndexIterator
+
+// --------
+// LogDeque
+// --------
+
+///
+/// An append-only deque that one thread writes with push_back while any number of threads read it without locks
+/// Element i lives at offset i % SIZET of inner array i / SIZET and never moves. When the outer array is full, push_back copies it
+/// to one twice as large and publishes the new one with a release store; the old outer arrays are kept until the LogDeque is
+/// destroyed, so a reader still using one never sees freed memory, and together they are smaller than the current one.
+/// push_back publishes the new size with a release store after constructing the element, so readers see every element below
+/// size() fully constructed. Reads are wait-free: size(), operator [], at, front, back, iterators and for_each_segment.
+/// Only one thread may call push_back at a time.
+/// @tparam T - Type of the elements
+/// @tparam A - Type of Allocator object used to define the storage allocation model; The default value - std::allocator
+///
+template < typename T, typename A = std::allocator<T> >
+class LogDeque
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef A                                                  allocator_type;
+	typedef typename std::allocator_traits<A>::value_type      value_type;
+
+	typedef typename std::allocator_traits<A>::size_type       size_type;
+	typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+	typedef typename std::allocator_traits<A>::pointer         pointer;
+	typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
+
+	typedef value_type&                                        reference;
+	typedef const value_type&                                  const_reference;
+
+	typedef IndexIterator<const LogDeque, value_type, const_reference, const_pointer> const_iterator;
+	typedef const_iterator                                                            iterator;
+
+	typedef typename std::allocator_traits<A>::template rebind_alloc<pointer> astar_type;
+
+private:
+	// ----
+	// data
+	// ----
+
+	allocator_type _a;
+	astar_type _astar;
+	pointer* map;     // the outer array readers use, published with a release store
+	size_type outer;  // the # of slots of map, which only the writer reads
+	size_type count;  // the # of elements readers may see, published with a release store
+	std::vector<std::pair<pointer*, size_type> > retired; // the outer arrays map replaced
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the LogDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		return (map == nullptr) ? (outer == 0 && count == 0) : (count <= outer * SIZET);
+	}
+
+	///
+	/// Copy the outer array to one twice as large, and publish it
+	///
+	void grow ()
+	{
+		size_type n = (outer == 0) ? 4 : 2 * outer;
+		pointer* x = _astar.allocate(n);
+		std::copy(map, map + outer, x);
+		std::fill(x + outer, x + n, pointer());
+		if(map != nullptr)
+			retired.push_back(std::make_pair(map, outer));
+		__atomic_store_n(&map, x, __ATOMIC_RELEASE);
+		outer = n;
+	}
+
+	///
+	/// @param index - element position in the container, below a size() the caller loaded
+	/// @return a pointer to the element
+	///
+	const_pointer locate (size_type index) const
+	{
+		pointer* x = __atomic_load_n(&map, __ATOMIC_ACQUIRE);
+		return __atomic_load_n(x + index / SIZET, __ATOMIC_ACQUIRE) + index % SIZET;
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty LogDeque container
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit LogDeque (const allocator_type& a = allocator_type()) : _a (a), map (nullptr), outer (0), count (0)
+	{
+		assert(valid());
+	}
+
+	LogDeque (const LogDeque&) = delete;
+	LogDeque& operator = (const LogDeque&) = delete;
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Destroys all elements and frees every inner array and outer array; no reader may be using the container
+	*/
+	~LogDeque ()
+	{
+		for(size_type i = 0; i != outer && map[i] != nullptr; ++i)
+		{
+			if(i * SIZET < count)
+				destroy(_a, map[i], map[i] + std::min<size_type>(SIZET, count - i * SIZET));
+			_a.deallocate(map[i], SIZET);
+		}
+		if(map != nullptr)
+			_astar.deallocate(map, outer);
+		for(size_type i = 0; i != retired.size(); ++i)
+			_astar.deallocate(retired[i].first, retired[i].second);
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator, which any thread may call
+	* @param index - element position in the container, below a size() the caller loaded
+	* @return a const reference to the element at the position in the container
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return *locate(index);
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns a const reference to the element at position index in the LogDeque container object
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not below size()
+	*/
+	const_reference at (size_type index) const
+	{
+		if(index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return a const reference to the last element published so far
+	*/
+	const_reference back () const
+	{
+		size_type n = size();
+		assert(n != 0);
+		return (*this)[n - 1];
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return a Const Iterator to the beginning of the LogDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* @return true if no element was published yet
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return a Const Iterator past the last element published so far, which stays valid as more elements are appended
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element, at most a size() the caller loaded
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - i % SIZET, j - i);
+			const_pointer x = locate(i);
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return a const reference to the first element of the LogDeque container
+	*/
+	const_reference front () const
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the LogDeque container and publish it; only one thread may call push_back at a time
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_back (const_reference v)
+	{
+		size_type i = count;
+		if(i % SIZET == 0)
+		{
+			if(i / SIZET == outer)
+				grow();
+			__atomic_store_n(map + i / SIZET, _a.allocate(SIZET), __ATOMIC_RELEASE);
+		}
+		pointer x = map[i / SIZET] + i % SIZET;
+		uninitialized_fill(_a, x, x + 1, v);
+		__atomic_store_n(&count, i + 1, __ATOMIC_RELEASE);
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the # of elements published so far, which any thread may read
+	*/
+	size_type size () const
+	{
+		return __atomic_load_n(&count, __ATOMIC_ACQUIRE);
+	}
+};
+
+#endif // LogDeque_h
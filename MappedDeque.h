@@ -0,0 +1,574 @@
+// -------------
+// MappedDeque.h
+// -------------
+
+#ifndef MappedDeque_h
+#define MappedDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>    // equal, lexicographical_compare, min
+#include <cassert>      // assert
+#include <cerrno>       // errno
+#include <cstring>      // memcmp, memcpy
+#include <new>          // new
+#include <stdexcept>    // out_of_range, runtime_error
+#include <stdint.h>     // uint64_t
+#include <system_error> // generic_category, system_error
+#include <type_traits>  // is_trivially_copyable
+
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, msync, munmap
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close, ftruncate, sysconf
+
+#include "Deque.h"      // SIZET, USIZET
+#include "Iterator.h"   // IndexIterator
+
+// -----------
+// MappedDeque
+// -----------
+
+///
+/// A deque whose inner arrays are pages of a memory-mapped file
+/// The file starts with a header holding the size, the front offset b and the file offset of the outer array,
+/// and the outer array holds the file offsets of the inner arrays, so the deque can be reopened without reading its elements.
+/// Like MyDeque, the outer array is circular.
+/// @tparam T - Type of the elements, which must be trivially copyable
+///
+template <typename T>
+class MappedDeque
+{
+	static_assert(std::is_trivially_copyable<T>::value, "MappedDeque requires a trivially copyable type");
+
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef T                 value_type;
+
+	typedef std::size_t       size_type;
+	typedef std::ptrdiff_t    difference_type;
+
+	typedef value_type*       pointer;
+	typedef const value_type* const_pointer;
+
+	typedef value_type&       reference;
+	typedef const value_type& const_reference;
+
+	typedef IndexIterator<MappedDeque, value_type, reference, pointer>                   iterator;
+	typedef IndexIterator<const MappedDeque, value_type, const_reference, const_pointer> const_iterator;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side MappedDeque
+	* @param rhs - the right hand side MappedDeque
+	* @return true if the lhs MappedDeque is equal to the rhs MappedDeque
+	*/
+	friend bool operator == (const MappedDeque& lhs, const MappedDeque& rhs)
+	{
+		return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side MappedDeque
+	* @param rhs - the right hand side MappedDeque
+	* @return true if the lhs MappedDeque is lexicographically less than the rhs MappedDeque
+	*/
+	friend bool operator < (const MappedDeque& lhs, const MappedDeque& rhs)
+	{
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+private:
+	// ------
+	// header
+	// ------
+
+	///
+	/// The first page of the file
+	///
+	struct header
+	{
+		char     magic[8];
+		uint64_t value_size;  // sizeof(T) of the elements in the file
+		uint64_t block_size;  // # of elements of an inner array
+		uint64_t block_bytes; // # of bytes of an inner array, a multiple of the page size
+		uint64_t count;       // # of elements
+		uint64_t b;           // offset of the first element in the first inner array
+		uint64_t head;        // index of the first inner array in the outer array
+		uint64_t outer;       // # of slots of the outer array
+		uint64_t map;         // file offset of the outer array
+		uint64_t length;      // # of bytes of the file in use
+	};
+
+	// ----
+	// data
+	// ----
+
+	int fd;
+	char* base;
+	size_type mapped;
+	size_type page;
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the MappedDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		const header& x = *h();
+		if(x.outer == 0)
+			return x.count == 0 && x.b == 0;
+		return x.b < USIZET && x.head < x.outer && x.b + x.count <= x.outer * USIZET && x.length <= mapped;
+	}
+
+	///
+	/// @return the header at the beginning of the file
+	///
+	header* h () const
+	{
+		return reinterpret_cast<header*>(base);
+	}
+
+	///
+	/// Find an inner array of the circular outer array
+	/// @param n - the number of inner arrays after the first inner array
+	/// @return a pointer to the inner array that is n slots after the first inner array, wrapping around at the end of the outer array
+	///
+	pointer block (size_type n) const
+	{
+		const uint64_t* map = reinterpret_cast<const uint64_t*>(base + h()->map);
+		return reinterpret_cast<pointer>(base + map[(h()->head + n) % h()->outer]);
+	}
+
+	///
+	/// Throw a system_error exception for the last failed system call
+	/// @param what - the name of the failed system call
+	///
+	static void fail (const char* what)
+	{
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	///
+	/// Round a number of bytes up to a multiple of the page size
+	/// @param n - a number of bytes
+	/// @return the smallest multiple of the page size that is not less than n
+	///
+	size_type round_up (size_type n) const
+	{
+		return (n + page - 1) / page * page;
+	}
+
+	///
+	/// Grow the file and map all of it
+	/// Invalidates every reference into the file
+	/// @param length - the new # of bytes of the file
+	///
+	void remap (size_type length)
+	{
+		if(ftruncate(fd, length) != 0)
+			fail("ftruncate");
+		if(base != nullptr && munmap(base, mapped) != 0)
+			fail("munmap");
+		base = nullptr;
+		void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if(p == MAP_FAILED)
+			fail("mmap");
+		base = static_cast<char*>(p);
+		mapped = length;
+	}
+
+	///
+	/// Append a larger outer array and new inner arrays to the file
+	/// The inner arrays in use are moved to the middle of the new outer array by their file offsets. The pages of the old outer
+	/// array become new inner arrays, as many as fit in them; what is left of them, less than an inner array, stays unused.
+	/// @param s - the minimum capacity of the new outer array
+	///
+	void rebuild (size_type s)
+	{
+		assert(s >= size());
+		const header old = *h();
+		size_type outer = 2 * ((s + SIZET - 1) / SIZET) + 1;
+		assert(outer > old.outer);
+		size_type map_bytes = round_up(outer * sizeof(uint64_t));
+		size_type reused = (old.outer == 0) ? 0 : std::min<size_type>(outer - old.outer, round_up(old.outer * sizeof(uint64_t)) / old.block_bytes);
+		size_type length = old.length + map_bytes + (outer - old.outer - reused) * old.block_bytes;
+		remap(length);
+
+		header& x = *h();
+		const uint64_t* old_map = reinterpret_cast<const uint64_t*>(base + old.map);
+		uint64_t* new_map = reinterpret_cast<uint64_t*>(base + old.length);
+		size_type head = outer / 2;
+		// The inner arrays in use keep their order, and the unused ones follow them
+		for(size_type i = 0; i != old.outer; ++i)
+			new_map[(head + i) % outer] = old_map[(old.head + i) % old.outer];
+		for(size_type i = old.outer; i != outer; ++i)
+		{
+			size_type j = i - old.outer;
+			new_map[(head + i) % outer] = (j < reused) ? old.map + j * old.block_bytes : old.length + map_bytes + (j - reused) * old.block_bytes;
+		}
+		x.map = old.length;
+		x.outer = outer;
+		x.head = head;
+		x.length = length;
+		assert(valid());
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Open a MappedDeque stored in a file, or create an empty one if the file is empty or does not exist
+	* @param path - the path of the file
+	* @throws system_error exception if the file cannot be opened or mapped
+	* @throws runtime_error exception if the file does not hold a MappedDeque of the same element type
+	*/
+	explicit MappedDeque (const char* path) : fd (-1), base (nullptr), mapped (0), page (sysconf(_SC_PAGESIZE))
+	{
+		fd = open(path, O_RDWR | O_CREAT, 0644);
+		if(fd < 0)
+			fail("open");
+		try
+		{
+			struct stat st;
+			if(fstat(fd, &st) != 0)
+				fail("fstat");
+			if(st.st_size == 0)
+			{
+				remap(page);
+				header& x = *h();
+				std::memcpy(x.magic, "MYDEQUE", 8);
+				x.value_size = sizeof(value_type);
+				x.block_size = SIZET;
+				x.block_bytes = round_up(SIZET * sizeof(value_type));
+				x.count = 0;
+				x.b = 0;
+				x.head = 0;
+				x.outer = 0;
+				x.map = 0;
+				x.length = page;
+			}
+			else
+			{
+				if(static_cast<size_type>(st.st_size) < sizeof(header))
+					throw std::runtime_error("MappedDeque: file is too short");
+				remap(st.st_size);
+				const header& x = *h();
+				if(std::memcmp(x.magic, "MYDEQUE", 8) != 0 || x.value_size != sizeof(value_type) || x.block_size != USIZET || x.length > mapped)
+					throw std::runtime_error("MappedDeque: file does not hold a MappedDeque of this type");
+			}
+		}
+		catch (...)
+		{
+			if(base != nullptr)
+				munmap(base, mapped);
+			close(fd);
+			throw;
+		}
+		assert(valid());
+	}
+
+	// The file has a single owner
+	MappedDeque (const MappedDeque&) = delete;
+	MappedDeque& operator = (const MappedDeque&) = delete;
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Unmaps and closes the file; the OS writes the dirty pages back
+	*/
+	~MappedDeque ()
+	{
+		munmap(base, mapped);
+		close(fd);
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	*/
+	reference operator [] (size_type index)
+	{
+		return block((index + h()->b) / SIZET)[(index + h()->b) % SIZET];
+	}
+
+	/**
+	* const subscript operator
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return const_cast<MappedDeque*>(this)->operator[](index);
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns a reference to the element at position index in the MappedDeque container object
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the MappedDeque container
+	*/
+	reference at (size_type index)
+	{
+		if (index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	/**
+	* Returns a const reference to the element at position index in the MappedDeque container object
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the MappedDeque container
+	*/
+	const_reference at (size_type index) const
+	{
+		return const_cast<MappedDeque*>(this)->at(index);
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return a reference to the last element of the MappedDeque container
+	*/
+	reference back ()
+	{
+		assert(!empty());
+		return (*this)[size() - 1];
+	}
+
+	/**
+	* Access last element
+	* @return a const reference to the last element of the MappedDeque container
+	*/
+	const_reference back () const
+	{
+		return const_cast<MappedDeque*>(this)->back();
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return an Iterator to the beginning of the MappedDeque container
+	*/
+	iterator begin ()
+	{
+		return iterator(this, 0);
+	}
+
+	/**
+	* @return a Const Iterator to the beginning of the MappedDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all elements of the MappedDeque container; the file keeps its inner arrays
+	*/
+	void clear ()
+	{
+		h()->count = 0;
+		assert(valid());
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the MappedDeque container is empty
+	* @return true if the MappedDeque container contains zero elements
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return an Iterator to the end of the MappedDeque container
+	*/
+	iterator end ()
+	{
+		return iterator(this, size());
+	}
+
+	/**
+	* @return a Const Iterator to the end of the MappedDeque container
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return a reference to the first element of the MappedDeque container
+	*/
+	reference front ()
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	/**
+	* Access first element
+	* @return a const reference to the first element of the MappedDeque container
+	*/
+	const_reference front () const
+	{
+		return const_cast<MappedDeque*>(this)->front();
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last element of the MappedDeque container
+	*/
+	void pop_back ()
+	{
+		assert(!empty());
+		--h()->count;
+		assert(valid());
+	}
+
+	/**
+	* Delete the first element of the MappedDeque container
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		header& x = *h();
+		++x.b;
+		if(x.b == USIZET)
+		{
+			x.head = (x.head + 1) % x.outer;
+			x.b = 0;
+		}
+		--x.count;
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the MappedDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_back (const_reference v)
+	{
+		// v may live in the file, which rebuild remaps
+		value_type x = v;
+		if(h()->b + size() + 1 > h()->outer * USIZET)
+			rebuild(size() + 1);
+		new (&(*this)[size()]) value_type(x);
+		++h()->count;
+		assert(valid());
+	}
+
+	/**
+	* Add element to the front of the MappedDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_front (const_reference v)
+	{
+		value_type x = v;
+		if(h()->outer == 0 || (h()->b == 0 && size() + SIZET > h()->outer * USIZET))
+			rebuild(size() + 1);
+		header& y = *h();
+		if(y.b == 0)
+		{
+			y.head = (y.head + y.outer - 1) % y.outer;
+			y.b = SIZET - 1;
+		}
+		else
+		{
+			--y.b;
+		}
+		new (&(*this)[0]) value_type(x);
+		++y.count;
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of elements in the MappedDeque container
+	*/
+	size_type size () const
+	{
+		return h()->count;
+	}
+
+	// ----
+	// sync
+	// ----
+
+	/**
+	* Write the elements and the header to the file and wait for the writes to complete
+	* @throws system_error exception if the writes fail
+	*/
+	void sync ()
+	{
+		if(msync(base, mapped, MS_SYNC) != 0)
+			fail("msync");
+	}
+};
+
+#endif // MappedDeque_h
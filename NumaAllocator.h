@@ -0,0 +1,195 @@
+// ---------------
+// NumaAllocator.h
+// ---------------
+
+#ifndef NumaAllocator_h
+#define NumaAllocator_h
+
+#include <cassert>  // assert
+#include <cstddef>  // ptrdiff_t, size_t
+#include <new>      // bad_alloc, new
+
+#include <sys/mman.h>    // mmap, munmap
+#include <sys/syscall.h> // SYS_get_mempolicy, SYS_mbind
+#include <unistd.h>      // syscall, sysconf
+
+///
+/// Where a Numa_Allocator places its blocks
+/// first_touch - wherever the first thread to write a page runs, which is the system default
+/// local - on the node of the allocating thread
+/// interleaved - page by page across every node the process may use
+/// pinned - on one node
+///
+enum Numa_Policy { first_touch, local, interleaved, pinned };
+
+namespace numa
+{
+    // The memory policy constants of <numaif.h>, which is part of libnuma
+    enum { mpol_default = 0, mpol_preferred = 1, mpol_bind = 2, mpol_interleave = 3, mpol_local = 4 };
+    enum { mpol_f_node = 1, mpol_f_addr = 2, mpol_f_mems_allowed = 4 };
+
+    const unsigned long max_node = 8 * sizeof(unsigned long);
+
+    ///
+    /// Set the memory policy of a range of pages, doing nothing where the system does not support it
+    /// @param p - the first page
+    /// @param n - the number of bytes
+    /// @param mode - a memory policy
+    /// @param mask - a bit mask of nodes
+    /// @return true if the policy was set
+    ///
+    inline bool mbind (void* p, std::size_t n, int mode, unsigned long mask)
+    {
+        #ifdef SYS_mbind
+        return syscall(SYS_mbind, p, n, mode, (mask == 0) ? nullptr : &mask, max_node, 0) == 0;
+        #else
+        return false;
+        #endif
+    }
+
+    ///
+    /// @return a bit mask of the nodes the process may use, or 0 if the system does not support NUMA policies
+    ///
+    inline unsigned long allowed ()
+    {
+        unsigned long mask = 0;
+        #ifdef SYS_get_mempolicy
+        if (syscall(SYS_get_mempolicy, nullptr, &mask, max_node, nullptr, mpol_f_mems_allowed) != 0)
+            return 0;
+        #endif
+        return mask;
+    }
+
+    ///
+    /// @param p - an address
+    /// @return the node of the page holding the address, or -1 if the system does not support NUMA policies
+    ///
+    inline int node (const void* p)
+    {
+        int n = -1;
+        #ifdef SYS_get_mempolicy
+        if (syscall(SYS_get_mempolicy, &n, nullptr, 0, p, mpol_f_node | mpol_f_addr) != 0)
+            return -1;
+        #endif
+        return n;
+    }
+}
+
+///
+/// An allocator that places page-aligned blocks according to a Numa_Policy with mbind, before any page is touched
+/// Each block is mapped on its own, so its pages are new and no page of it was placed under another policy; unmapping it
+/// drops the policy with the pages.
+/// Without NUMA support in the system, or with libnuma absent, the policy is ignored.
+/// @tparam T - Type of the elements
+///
+template <typename T>
+struct Numa_Allocator
+{
+    typedef T                 value_type;
+
+    typedef std::size_t       size_type;
+    typedef std::ptrdiff_t    difference_type;
+
+    typedef value_type*       pointer;
+    typedef const value_type* const_pointer;
+
+    typedef value_type&       reference;
+    typedef const value_type& const_reference;
+
+    friend bool operator == (const Numa_Allocator& lhs, const Numa_Allocator& rhs)
+    {
+        return (lhs._policy == rhs._policy) && (lhs._node == rhs._node);
+    }
+
+    friend bool operator != (const Numa_Allocator& lhs, const Numa_Allocator& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    ///
+    /// @param p - the Numa_Policy
+    /// @param n - the node of the pinned policy
+    ///
+    explicit Numa_Allocator (Numa_Policy p = first_touch, int n = 0) : _policy (p), _node (n)
+    {}
+
+    template <typename U>
+    Numa_Allocator (const Numa_Allocator<U>& that) : _policy (that.policy()), _node (that.node())
+    {}
+
+    // Default copy, destructor, and copy assignment
+    // Numa_Allocator  (const Numa_Allocator&);
+    // ~Numa_Allocator ();
+    // Numa_Allocator& operator = (const Numa_Allocator&);
+
+    Numa_Policy policy () const
+    {
+        return _policy;
+    }
+
+    int node () const
+    {
+        return _node;
+    }
+
+    pointer allocate (size_type n)
+    {
+        size_type bytes = pages(n);
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        switch (_policy)
+        {
+            case local:
+                numa::mbind(p, bytes, numa::mpol_local, 0);
+                break;
+            case interleaved:
+                numa::mbind(p, bytes, numa::mpol_interleave, numa::allowed());
+                break;
+            case pinned:
+                numa::mbind(p, bytes, numa::mpol_bind, (_node >= 0 && _node < static_cast<int>(numa::max_node)) ? 1UL << _node : 0);
+                break;
+            case first_touch:
+                break;
+        }
+        return static_cast<pointer>(p);
+    }
+
+    void construct (pointer p, const_reference v)
+    {
+        new (p) value_type(v);
+    }
+
+    void deallocate (pointer p, size_type n)
+    {
+        assert(p);
+        munmap(p, pages(n));
+    }
+
+    void destroy (pointer p)
+    {
+        p->~value_type();
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        typedef Numa_Allocator<U> other;
+    };
+
+private:
+    Numa_Policy _policy;
+    int _node;
+
+    ///
+    /// @param n - the number of elements
+    /// @return the number of bytes of the whole pages holding them
+    ///
+    static size_type pages (size_type n)
+    {
+        static const size_type page = sysconf(_SC_PAGESIZE);
+        return (n * sizeof(value_type) + page - 1) / page * page;
+    }
+};
+
+#endif // NumaAllocator_h
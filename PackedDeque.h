@@ -0,0 +1,969 @@
+// -------------
+// PackedDeque.h
+// -------------
+
+#ifndef PackedDeque_h
+#define PackedDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // equal, fill, lexicographical_compare, max, min, swap
+#include <cassert>     // assert
+#include <cstddef>     // ptrdiff_t, size_t
+#include <cstdint>     // int64_t, uint64_t
+#include <iterator>    // bidirectional_iterator_tag
+#include <memory>      // allocator, allocator_traits
+#include <stdexcept>   // out_of_range
+#include <type_traits> // conditional, is_integral, is_signed
+#include <vector>      // vector
+
+#include "Deque.h" // SIZET, USIZET
+
+///
+/// The # of elements between two checkpoints of a delta packed inner array, which bounds the work of operator []
+///
+const std::size_t PACKQ = 64;
+
+// -----------
+// PackedDeque
+// -----------
+
+///
+/// A deque of integers, such as timestamps and IDs, whose interior inner arrays are frozen into a bit packed encoding
+/// Like MyDeque, it keeps SIZET elements per inner array in a circular outer array. The inner array at each end, where elements
+/// are pushed and popped, is always raw. A push that starts a new end inner array freezes the inner array two away from it with
+/// whichever encoding is smaller:
+/// - frame of reference: element i is base + i * slope + r[i], where slope is the average step of the inner array, so that a
+///   steady sequence leaves small residuals r; operator [] decodes it in O(1)
+/// - delta: element i is element i - 1 + slope + r[i], where slope is the smallest step, so that a jittery sequence leaves small
+///   residuals; a checkpoint every PACKQ elements bounds operator [] to PACKQ steps
+/// Residuals are packed with the fewest bits that hold the largest of them. A pop thaws only the inner array that becomes an end,
+/// so the inner array next to an end may stay frozen; thawing it too would make pushes and pops across an inner array boundary
+/// freeze and thaw it again and again. An inner array is thawed only after a whole inner array was popped since it was frozen,
+/// so push and pop stay amortized O(1).
+/// Elements are decoded on the fly, so they are read through values instead of references. An iterator keeps the element it
+/// read last, so stepping it through a delta packed inner array adds one residual instead of up to PACKQ. for_each_segment
+/// decodes runs of a frozen inner array into a buffer, which is the fast way to scan the container.
+/// @tparam T - Type of the elements, an integral type of at most 64 bits
+/// @tparam A - Type of Allocator object used to define the storage allocation model; The default value - std::allocator
+///
+template < typename T, typename A = std::allocator<T> >
+class PackedDeque
+{
+	static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(std::uint64_t), "PackedDeque requires an integral type of at most 64 bits");
+
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef A                                                  allocator_type;
+	typedef typename std::allocator_traits<A>::value_type      value_type;
+
+	typedef typename std::allocator_traits<A>::size_type       size_type;
+	typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+	typedef typename std::allocator_traits<A>::pointer         pointer;
+	typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
+
+	typedef value_type                                         reference;
+	typedef value_type                                         const_reference;
+
+	class const_iterator;
+	typedef const_iterator                                     iterator;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side PackedDeque
+	* @param rhs - the right hand side PackedDeque
+	* @return true if the lhs PackedDeque is equal to the rhs PackedDeque
+	*/
+	friend bool operator == (const PackedDeque& lhs, const PackedDeque& rhs)
+	{
+		return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side PackedDeque
+	* @param rhs - the right hand side PackedDeque
+	* @return true if the lhs PackedDeque is lexicographically less than the rhs PackedDeque
+	*/
+	friend bool operator < (const PackedDeque& lhs, const PackedDeque& rhs)
+	{
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+private:
+	typedef std::uint64_t word;
+
+	typedef typename std::allocator_traits<A>::template rebind_alloc<word> word_allocator;
+
+	///
+	/// An inner array, either raw or frozen, or neither if it was never used
+	///
+	struct block
+	{
+		pointer raw;    // the elements of a raw inner array
+		word* bits;     // the checkpoints of a delta packed inner array, then its residuals and a word of padding
+		word base;
+		word slope;
+		unsigned width; // the # of bits of each residual
+		bool delta;
+
+		block () : raw (pointer()), bits (nullptr), base (0), slope (0), width (0), delta (false)
+		{}
+	};
+
+	// ----
+	// data
+	// ----
+
+	allocator_type _a;
+	word_allocator _wa;
+	std::vector<block> map; // the circular outer array
+	size_type head;         // the slot of the first inner array
+	size_type b;            // the offset of the first element in the first inner array
+	size_type count;        // the # of elements
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the PackedDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		if(map.empty())
+			return head == 0 && b == 0 && count == 0;
+		return (head < map.size()) && (b < USIZET) && (b + count <= map.size() * USIZET) &&
+			(count == 0 || (slot(0).raw != nullptr && slot((b + count - 1) / SIZET).raw != nullptr));
+	}
+
+	///
+	/// Find an inner array of the circular outer array
+	/// @param k - the number of inner arrays after the first inner array
+	/// @return the inner array
+	///
+	block& slot (size_type k)
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	const block& slot (size_type k) const
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	///
+	/// @param v - an element
+	/// @return the element as a 64 bit word, sign extended if it is signed, which all the arithmetic of the encodings wraps around
+	///
+	static word widen (value_type v)
+	{
+		typedef typename std::conditional<std::is_signed<T>::value, std::int64_t, std::uint64_t>::type wide;
+		return static_cast<word>(static_cast<wide>(v));
+	}
+
+	///
+	/// @param m - a residual
+	/// @return the # of bits that hold it
+	///
+	static unsigned bits_of (word m)
+	{
+		return (m == 0) ? 0 : 64 - __builtin_clzll(m);
+	}
+
+	///
+	/// @param x - a frozen inner array
+	/// @return the # of words of its bits
+	///
+	static size_type words (const block& x)
+	{
+		return (x.delta ? (SIZET + PACKQ - 1) / PACKQ : 0) + (SIZET * x.width + 63) / 64 + 1;
+	}
+
+	///
+	/// @param p - packed residuals, followed by a word of padding
+	/// @param i - the index of a residual
+	/// @param w - the # of bits of each residual
+	/// @return the residual
+	///
+	static word extract (const word* p, size_type i, unsigned w)
+	{
+		if(w == 0)
+			return 0;
+		size_type s = i * w;
+		word r = p[s / 64] >> (s % 64);
+		if(s % 64 + w > 64)
+			r |= p[s / 64 + 1] << (64 - s % 64);
+		return (w == 64) ? r : r & ((word(1) << w) - 1);
+	}
+
+	///
+	/// @param p - words set to zero with room for the residuals
+	/// @param i - the index of a residual
+	/// @param w - the # of bits of each residual
+	/// @param r - the residual
+	///
+	static void deposit (word* p, size_type i, unsigned w, word r)
+	{
+		if(w == 0)
+			return;
+		size_type s = i * w;
+		p[s / 64] |= r << (s % 64);
+		if(s % 64 + w > 64)
+			p[s / 64 + 1] |= r >> (64 - s % 64);
+	}
+
+	///
+	/// @param x - an inner array in use
+	/// @param i - an offset in it
+	/// @return the element at the offset
+	///
+	static value_type decode (const block& x, size_type i)
+	{
+		if(x.raw != nullptr)
+			return x.raw[i];
+		if(!x.delta)
+			return static_cast<value_type>(x.base + i * x.slope + extract(x.bits, i, x.width));
+		const word* r = x.bits + (SIZET + PACKQ - 1) / PACKQ;
+		word v = x.bits[i / PACKQ];
+		for(size_type t = i - i % PACKQ + 1; t <= i; ++t)
+			v += x.slope + extract(r, t, x.width);
+		return static_cast<value_type>(v);
+	}
+
+	///
+	/// Decode a run of an inner array, in O(1) per element
+	/// @param x - an inner array in use
+	/// @param i - the offset of the first element
+	/// @param j - the offset past the last element
+	/// @param out - where the elements go
+	///
+	static void decode (const block& x, size_type i, size_type j, value_type* out)
+	{
+		if(i == j)
+			return;
+		if(x.raw != nullptr)
+			std::copy(x.raw + i, x.raw + j, out);
+		else if(!x.delta)
+		{
+			for(size_type t = i; t != j; ++t)
+				out[t - i] = static_cast<value_type>(x.base + t * x.slope + extract(x.bits, t, x.width));
+		}
+		else
+		{
+			const word* r = x.bits + (SIZET + PACKQ - 1) / PACKQ;
+			word v = widen(decode(x, i));
+			out[0] = static_cast<value_type>(v);
+			for(size_type t = i + 1; t != j; ++t)
+			{
+				v += x.slope + extract(r, t, x.width);
+				out[t - i] = static_cast<value_type>(v);
+			}
+		}
+	}
+
+	///
+	/// Find an element from the element next to it, which is O(1) in a delta packed inner array too
+	/// @param index - element position in the container
+	/// @param at - the position of a known element, or any position that is not in the container
+	/// @param v - the known element, widened
+	/// @return the element at the position, widened
+	///
+	word step (size_type index, size_type at, word v) const
+	{
+		const block& x = slot((b + index) / SIZET);
+		size_type o = (b + index) % SIZET;
+		if(x.raw == nullptr && x.delta && at < count)
+		{
+			const word* r = x.bits + (SIZET + PACKQ - 1) / PACKQ;
+			if(at + 1 == index && o != 0)
+				return v + x.slope + extract(r, o, x.width);
+			if(index + 1 == at && o != USIZET - 1)
+				return v - x.slope - extract(r, o + 1, x.width);
+		}
+		return widen(decode(x, o));
+	}
+
+	///
+	/// Encode a full raw inner array with the smaller of the two encodings, and free its raw elements
+	/// It does nothing to an inner array that is already frozen.
+	/// @param k - the number of inner arrays after the first inner array, which is neither the first nor the last one
+	///
+	void freeze (size_type k)
+	{
+		block& x = slot(k);
+		if(x.raw == nullptr)
+			return;
+		const_pointer p = x.raw;
+
+		// frame of reference along the line from the first element to the last one, or along a flat line if that is tighter
+		block f;
+		for(int flat = 0; flat != 2; ++flat)
+		{
+			word s = flat ? 0 : static_cast<word>(static_cast<std::int64_t>(widen(p[SIZET - 1]) - widen(p[0])) / static_cast<std::int64_t>(SIZET - 1));
+			std::int64_t lo = 0;
+			for(size_type i = 1; i != SIZET; ++i)
+				lo = std::min<std::int64_t>(lo, static_cast<std::int64_t>(widen(p[i]) - widen(p[0]) - i * s));
+			word o = 0;
+			for(size_type i = 0; i != SIZET; ++i)
+				o |= widen(p[i]) - widen(p[0]) - i * s - static_cast<word>(lo);
+			if(flat == 0 || bits_of(o) < f.width)
+			{
+				f.base = widen(p[0]) + static_cast<word>(lo);
+				f.slope = s;
+				f.width = bits_of(o);
+			}
+		}
+
+		// deltas above the smallest step
+		block d;
+		d.delta = true;
+		std::int64_t lo = static_cast<std::int64_t>(widen(p[1]) - widen(p[0]));
+		for(size_type i = 2; i != SIZET; ++i)
+			lo = std::min<std::int64_t>(lo, static_cast<std::int64_t>(widen(p[i]) - widen(p[i - 1])));
+		d.slope = static_cast<word>(lo);
+		word o = 0;
+		for(size_type i = 1; i != SIZET; ++i)
+			o |= widen(p[i]) - widen(p[i - 1]) - d.slope;
+		d.width = bits_of(o);
+
+		block y = (words(d) < words(f)) ? d : f;
+		y.bits = _wa.allocate(words(y));
+		std::fill(y.bits, y.bits + words(y), word(0));
+		if(y.delta)
+		{
+			word* r = y.bits + (SIZET + PACKQ - 1) / PACKQ;
+			for(size_type i = 0; i < SIZET; i += PACKQ)
+				y.bits[i / PACKQ] = widen(p[i]);
+			for(size_type i = 1; i != SIZET; ++i)
+				deposit(r, i, y.width, widen(p[i]) - widen(p[i - 1]) - y.slope);
+		}
+		else
+		{
+			for(size_type i = 0; i != SIZET; ++i)
+				deposit(y.bits, i, y.width, widen(p[i]) - y.base - i * y.slope);
+		}
+		_a.deallocate(x.raw, SIZET);
+		x = y;
+	}
+
+	///
+	/// Decode a frozen inner array back to raw elements; it does nothing to an inner array that is already raw
+	/// @param k - the number of inner arrays after the first inner array
+	///
+	void thaw (size_type k)
+	{
+		block& x = slot(k);
+		if(x.raw != nullptr)
+			return;
+		block y;
+		y.raw = _a.allocate(SIZET);
+		decode(x, 0, SIZET, &*y.raw);
+		_wa.deallocate(x.bits, words(x));
+		x = y;
+	}
+
+	///
+	/// Give up an inner array, raw or frozen
+	/// @param x - the inner array
+	///
+	void release (block& x)
+	{
+		if(x.raw != nullptr)
+			_a.deallocate(x.raw, SIZET);
+		else if(x.bits != nullptr)
+			_wa.deallocate(x.bits, words(x));
+		x = block();
+	}
+
+	///
+	/// Allocate a raw inner array for an unused slot if it has none
+	/// @param k - the number of inner arrays after the first inner array
+	/// @return the raw elements
+	///
+	pointer raw (size_type k)
+	{
+		block& x = slot(k);
+		assert(x.bits == nullptr);
+		if(x.raw == nullptr)
+			x.raw = _a.allocate(SIZET);
+		return x.raw;
+	}
+
+	///
+	/// Move the inner arrays to the middle of a larger circular outer array, in order
+	/// @param s - the minimum # of elements of the new outer array
+	///
+	void rebuild (size_type s)
+	{
+		assert(s >= count);
+		size_type outer = 2 * ((s + SIZET - 1) / SIZET) + 1;
+		assert(outer > map.size());
+		std::vector<block> x(outer);
+		size_type h = outer / 2;
+		for(size_type i = 0; i != map.size(); ++i)
+			x[(h + i) % outer] = slot(i);
+		map.swap(x);
+		head = h;
+		assert(valid());
+	}
+
+public:
+	// --------------
+	// const_iterator
+	// --------------
+
+	///
+	/// A const bidirectional iterator for the PackedDeque class, which keeps the element it read last and its position
+	///
+	class const_iterator
+	{
+	public:
+		// --------
+		// typedefs
+		// --------
+
+		typedef std::bidirectional_iterator_tag       iterator_category;
+		typedef typename PackedDeque::value_type      value_type;
+		typedef typename PackedDeque::difference_type difference_type;
+		typedef void                                  pointer;
+		typedef typename PackedDeque::const_reference reference;
+
+	public:
+		// -----------
+		// operator ==
+		// -----------
+
+		/**
+		* equal operator
+		* @param lhs - the left hand side Const_Iterator
+		* @param rhs - the right hand side Const_Iterator
+		* @return true if the lhs Const_Iterator is equal to the rhs Const_Iterator
+		*/
+		friend bool operator == (const const_iterator& lhs, const const_iterator& rhs)
+		{
+			return (lhs._p == rhs._p) && (lhs._index == rhs._index);
+		}
+
+		/**
+		* not equal operator
+		* @param lhs - the left hand side Const_Iterator
+		* @param rhs - the right hand side Const_Iterator
+		* @return true if the lhs Const_Iterator is not equal to the rhs Const_Iterator
+		*/
+		friend bool operator != (const const_iterator& lhs, const const_iterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+		// ----------
+		// operator +
+		// ----------
+
+		/**
+		* addition operator
+		* @param lhs - the left hand side Const_Iterator
+		* @param rhs - the right hand side difference_type
+		* @return a Const_Iterator shifted forward by the difference_type value
+		*/
+		friend const_iterator operator + (const_iterator lhs, difference_type rhs)
+		{
+			return lhs += rhs;
+		}
+
+		// ----------
+		// operator -
+		// ----------
+
+		/**
+		* subtraction operator
+		* @param lhs - the left hand side Const_Iterator
+		* @param rhs - the right hand side difference_type
+		* @return a Const_Iterator shifted backward by the difference_type value
+		*/
+		friend const_iterator operator - (const_iterator lhs, difference_type rhs)
+		{
+			return lhs -= rhs;
+		}
+
+	private:
+		// ----
+		// data
+		// ----
+		const PackedDeque* _p;
+		size_type          _index;
+		mutable size_type  _at; // the position of the element read last, or -1
+		mutable word       _v;  // the element read last, widened
+
+	public:
+		// -----------
+		// constructor
+		// -----------
+
+		/**
+		* Create a Const_Iterator object using the PackedDeque container
+		* @param p - a const pointer to the PackedDeque container
+		* @param i - index state for the Const_Iterator
+		*/
+		const_iterator (const PackedDeque* p = nullptr, size_type i = 0) : _p(p), _index(i), _at(-1), _v(0)
+		{}
+
+		// Default copy, destructor, and copy assignment.
+		// const_iterator (const const_iterator&);
+		// ~const_iterator ();
+		// const_iterator& operator = (const const_iterator&);
+
+		// ----------
+		// operator *
+		// ----------
+
+		/**
+		* dereference operator, O(1) when the Const_Iterator moved by one since it was last dereferenced
+		* @return the value in the Const_Iterator's current state
+		*/
+		reference operator * () const
+		{
+			assert(_index < _p->size());
+			if(_at != _index)
+			{
+				_v = _p->step(_index, _at, _v);
+				_at = _index;
+			}
+			return static_cast<value_type>(_v);
+		}
+
+		// -----------
+		// operator ++
+		// -----------
+
+		/**
+		* Pre-increment Operator
+		* @return a Const_Iterator reference incremented by 1
+		*/
+		const_iterator& operator ++ ()
+		{
+			++_index;
+			return *this;
+		}
+
+		/**
+		* Post-Increment Operator
+		* @return a Const_Iterator incremented by 1
+		*/
+		const_iterator operator ++ (int)
+		{
+			const_iterator x = *this;
+			++(*this);
+			return x;
+		}
+
+		// -----------
+		// operator --
+		// -----------
+
+		/**
+		* Pre-decrement Operator
+		* @return a Const_Iterator reference decremented by 1
+		*/
+		const_iterator& operator -- ()
+		{
+			--_index;
+			return *this;
+		}
+
+		/**
+		* Post-Decrement Operator
+		* @return a Const_Iterator decremented by 1
+		*/
+		const_iterator operator -- (int)
+		{
+			const_iterator x = *this;
+			--(*this);
+			return x;
+		}
+
+		// -----------
+		// operator +=
+		// -----------
+
+		/**
+		* Addition Assignent Operator
+		* @param d - the right hand side difference_type
+		* @return a Const_Iterator reference shifted forward by the difference_type value
+		*/
+		const_iterator& operator += (difference_type d)
+		{
+			_index += d;
+			return *this;
+		}
+
+		// -----------
+		// operator -=
+		// -----------
+
+		/**
+		* Subtraction Assignent Operator
+		* @param d - the right hand side difference_type
+		* @return a Const_Iterator reference shifted backward by the difference_type value
+		*/
+		const_iterator& operator -= (difference_type d)
+		{
+			_index -= d;
+			return *this;
+		}
+	};
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty PackedDeque container
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit PackedDeque (const allocator_type& a = allocator_type()) : _a (a), _wa (a), head (0), b (0), count (0)
+	{
+		assert(valid());
+	}
+
+	/**
+	* Copy Constructor - Copy the elements of another PackedDeque container, which are frozen again as they are appended
+	* @param that - another PackedDeque container
+	*/
+	PackedDeque (const PackedDeque& that) : _a (that._a), _wa (that._wa), head (0), b (0), count (0)
+	{
+		that.for_each_segment(0, that.size(), [this] (const value_type* x, const value_type* y)
+		{
+			for(; x != y; ++x)
+				push_back(*x);
+		});
+		assert(valid());
+	}
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Frees every inner array; the elements are integers, so nothing is destroyed
+	*/
+	~PackedDeque ()
+	{
+		for(size_type i = 0; i != map.size(); ++i)
+			release(map[i]);
+	}
+
+	// ----------
+	// operator =
+	// ----------
+
+	/**
+	* Copy Assignment Operator
+	* @param that - another PackedDeque container
+	* @return a reference to this PackedDeque container
+	*/
+	PackedDeque& operator = (const PackedDeque& that)
+	{
+		if(this != &that)
+		{
+			PackedDeque x(that);
+			swap(x);
+		}
+		return *this;
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator, O(1) except in a delta packed inner array, where it adds up to PACKQ residuals
+	* @param index - element position in the container
+	* @return the element at the position in the container
+	*/
+	value_type operator [] (size_type index) const
+	{
+		return decode(slot((b + index) / SIZET), (b + index) % SIZET);
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns the element at position index in the PackedDeque container object
+	* @param index - element position in the container
+	* @return the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the PackedDeque container
+	*/
+	value_type at (size_type index) const
+	{
+		if(index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return the last element of the PackedDeque container
+	*/
+	value_type back () const
+	{
+		assert(!empty());
+		return (*this)[count - 1];
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return a Const Iterator to the beginning of the PackedDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all elements of the PackedDeque container and free its inner arrays
+	*/
+	void clear ()
+	{
+		for(size_type i = 0; i != map.size(); ++i)
+			release(map[i]);
+		map.clear();
+		head = b = count = 0;
+		assert(valid());
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the PackedDeque container is empty
+	* @return true if the PackedDeque container contains zero elements
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return a Const Iterator to the end of the PackedDeque container
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on contiguous runs of the elements [i, j): the elements of a raw inner array in place, and those of a
+	* frozen one decoded into a buffer, in O(1) per element
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a run
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j && j <= count);
+		value_type buffer[4 * PACKQ];
+		while(i < j)
+		{
+			const block& x = slot((b + i) / SIZET);
+			size_type o = (b + i) % SIZET;
+			size_type n = std::min<size_type>(SIZET - o, j - i);
+			if(x.raw != nullptr)
+				f(&x.raw[o], &x.raw[o] + n);
+			else
+			{
+				n = std::min<size_type>(n, 4 * PACKQ);
+				decode(x, o, o + n, buffer);
+				f(static_cast<const value_type*>(buffer), buffer + n);
+			}
+			i += n;
+		}
+		return f;
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return the first element of the PackedDeque container
+	*/
+	value_type front () const
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last element of the PackedDeque container, thawing the inner array before it if it becomes the last one
+	*/
+	void pop_back ()
+	{
+		assert(!empty());
+		--count;
+		if(count != 0 && (b + count) % SIZET == 0)
+			thaw((b + count - 1) / SIZET);
+		assert(valid());
+	}
+
+	/**
+	* Delete the first element of the PackedDeque container, thawing the inner array after it if it becomes the first one
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		++b;
+		--count;
+		if(b == USIZET)
+		{
+			head = (head + 1) % map.size();
+			b = 0;
+			if(count != 0)
+				thaw(0);
+		}
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the PackedDeque container, freezing the inner array two before a new last one
+	* @param v - the value of the new element
+	*/
+	void push_back (value_type v)
+	{
+		if(b + count + 1 > map.size() * USIZET)
+			rebuild(count + 1);
+		size_type k = (b + count) / SIZET;
+		std::allocator_traits<A>::construct(_a, &*raw(k) + (b + count) % SIZET, v);
+		++count;
+		if((b + count - 1) % SIZET == 0 && k >= 4)
+			freeze(k - 2);
+		assert(valid());
+	}
+
+	/**
+	* Add element to the front of the PackedDeque container, freezing the inner array two after a new first one
+	* @param v - the value of the new element
+	*/
+	void push_front (value_type v)
+	{
+		if(map.empty() || (b == 0 && count + SIZET > map.size() * USIZET))
+			rebuild(count + 1);
+		if(b == 0)
+		{
+			std::allocator_traits<A>::construct(_a, &*raw(map.size() - 1) + SIZET - 1, v);
+			head = (head + map.size() - 1) % map.size();
+			b = SIZET - 1;
+			++count;
+			if((b + count - 1) / SIZET >= 4)
+				freeze(2);
+		}
+		else
+		{
+			std::allocator_traits<A>::construct(_a, &*slot(0).raw + b - 1, v);
+			--b;
+			++count;
+		}
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of elements in the PackedDeque container
+	*/
+	size_type size () const
+	{
+		return count;
+	}
+
+	// -------
+	// storage
+	// -------
+
+	/**
+	* @return the # of bytes of the inner arrays, raw and frozen, which excludes the outer array
+	*/
+	size_type storage () const
+	{
+		size_type n = 0;
+		for(size_type i = 0; i != map.size(); ++i)
+			if(map[i].raw != nullptr)
+				n += SIZET * sizeof(value_type);
+			else if(map[i].bits != nullptr)
+				n += words(map[i]) * sizeof(word);
+		return n;
+	}
+
+	// ----
+	// swap
+	// ----
+
+	/**
+	* Exchange the contents of two PackedDeque containers
+	* @param that - another PackedDeque container
+	*/
+	void swap (PackedDeque& that)
+	{
+		std::swap(_a, that._a);
+		std::swap(_wa, that._wa);
+		map.swap(that.map);
+		std::swap(head, that.head);
+		std::swap(b, that.b);
+		std::swap(count, that.count);
+	}
+};
+
+#endif // PackedDeque_h
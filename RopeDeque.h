@@ -0,0 +1,853 @@
+// -----------
+// RopeDeque.h
+// -----------
+
+#ifndef RopeDeque_h
+#define RopeDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // copy, copy_backward, equal, lexicographical_compare, swap
+#include <cassert>   // assert
+#include <cstddef>   // ptrdiff_t, size_t
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // out_of_range
+#include <utility>   // pair
+#include <vector>    // vector
+
+#include "Deque.h"    // SIZET, USIZET
+#include "Iterator.h" // IndexIterator
+
+// ---------
+// RopeDeque
+// ---------
+
+///
+/// A deque of partially filled inner arrays, indexed by a Fenwick tree over the # of elements in each inner array
+/// Indexing is O(log n), push and pop at either end are amortized O(1), and insert and erase in the middle shift at most
+/// one inner array. When an inner array splits or empties, the slots of the outer array move and the Fenwick tree is
+/// rebuilt, which is O(n / SIZET) but happens at most once per SIZET / 2 inserts or erases into that inner array.
+/// @tparam T - Type of the elements
+/// @tparam A - Type of the allocator
+///
+template <typename T, typename A = std::allocator<T> >
+class RopeDeque
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef A                                                  allocator_type;
+	typedef typename std::allocator_traits<A>::value_type      value_type;
+
+	typedef typename std::allocator_traits<A>::size_type       size_type;
+	typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+	typedef typename std::allocator_traits<A>::pointer         pointer;
+	typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
+
+	typedef value_type&                                        reference;
+	typedef const value_type&                                  const_reference;
+
+	typedef IndexIterator<RopeDeque, value_type, reference, pointer>                   iterator;
+	typedef IndexIterator<const RopeDeque, value_type, const_reference, const_pointer> const_iterator;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side RopeDeque
+	* @param rhs - the right hand side RopeDeque
+	* @return true if the lhs RopeDeque is equal to the rhs RopeDeque
+	*/
+	friend bool operator == (const RopeDeque& lhs, const RopeDeque& rhs)
+	{
+		return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side RopeDeque
+	* @param rhs - the right hand side RopeDeque
+	* @return true if the lhs RopeDeque is lexicographically less than the rhs RopeDeque
+	*/
+	friend bool operator < (const RopeDeque& lhs, const RopeDeque& rhs)
+	{
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+private:
+	// ----
+	// node
+	// ----
+
+	///
+	/// An inner array whose elements are [p + lo, p + hi)
+	///
+	struct node
+	{
+		pointer p;
+		size_type lo;
+		size_type hi;
+
+		size_type size () const
+		{
+			return hi - lo;
+		}
+	};
+
+	// ----
+	// data
+	// ----
+
+	allocator_type _a;
+	std::vector<node> blocks;    // the outer array; the slots [first, last) are in use
+	std::vector<size_type> tree; // the Fenwick tree over the # of elements of each slot
+	size_type first;
+	size_type last;
+	size_type count;
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the RopeDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		return (first <= last) && (last <= blocks.size()) && (tree.size() == blocks.size()) && (prefix(blocks.size()) == count);
+	}
+
+	// ------------
+	// fenwick tree
+	// ------------
+
+	///
+	/// Add to the # of elements of a slot
+	/// @param k - the slot
+	/// @param d - the change of its # of elements
+	///
+	void add (size_type k, difference_type d)
+	{
+		for(++k; k <= tree.size(); k += k & -k)
+			tree[k - 1] += d;
+	}
+
+	///
+	/// @param k - a slot
+	/// @return the # of elements in the slots before k
+	///
+	size_type prefix (size_type k) const
+	{
+		size_type n = 0;
+		for(; k > 0; k -= k & -k)
+			n += tree[k - 1];
+		return n;
+	}
+
+	///
+	/// Find an element by its index
+	/// @param index - element position in the container, less than size()
+	/// @return the slot holding the element and the position of the element among those of the slot
+	///
+	std::pair<size_type, size_type> locate (size_type index) const
+	{
+		assert(index < count);
+		size_type k = 0;
+		size_type step = 1;
+		while(2 * step <= tree.size())
+			step *= 2;
+		for(; step != 0; step /= 2)
+		{
+			if(k + step <= tree.size() && tree[k + step - 1] <= index)
+			{
+				k += step;
+				index -= tree[k - 1];
+			}
+		}
+		return std::make_pair(k, index);
+	}
+
+	///
+	/// Rebuild the Fenwick tree from the # of elements of each slot in O(slots)
+	///
+	void index ()
+	{
+		tree.assign(blocks.size(), 0);
+		for(size_type k = first; k != last; ++k)
+			tree[k] = blocks[k].size();
+		for(size_type k = 1; k <= tree.size(); ++k)
+		{
+			size_type j = k + (k & -k);
+			if(j <= tree.size())
+				tree[j - 1] += tree[k - 1];
+		}
+	}
+
+	// -------
+	// rebuild
+	// -------
+
+	///
+	/// Move the slots in use to the middle of a new outer array with room for s more slots, and rebuild the Fenwick tree
+	/// @param s - the # of free slots the new outer array needs
+	///
+	void rebuild (size_type s)
+	{
+		size_type used = last - first;
+		size_type slots = 2 * (used + s) + 2;
+		std::vector<node> x(slots);
+		size_type k = (slots - used) / 2;
+		std::copy(blocks.begin() + first, blocks.begin() + last, x.begin() + k);
+		blocks.swap(x);
+		first = k;
+		last = k + used;
+		index();
+	}
+
+	///
+	/// Open an empty slot before slot k, shifting the slots on the shorter side into the free slots
+	/// @param k - a slot in [first, last]
+	/// @return the new slot, which the caller fills before the Fenwick tree is rebuilt
+	///
+	size_type open (size_type k)
+	{
+		assert(first <= k && k <= last);
+		if(first == 0 && last == blocks.size())
+		{
+			size_type i = k - first;
+			rebuild(1);
+			k = first + i;
+		}
+		if((k - first < last - k && first > 0) || last == blocks.size())
+		{
+			std::copy(blocks.begin() + first, blocks.begin() + k, blocks.begin() + first - 1);
+			--first;
+			--k;
+		}
+		else
+		{
+			std::copy_backward(blocks.begin() + k, blocks.begin() + last, blocks.begin() + last + 1);
+			++last;
+		}
+		return k;
+	}
+
+	///
+	/// Free an empty inner array and close its slot
+	/// @param k - a slot in use whose inner array is empty
+	///
+	void close (size_type k)
+	{
+		assert(blocks[k].size() == 0);
+		_a.deallocate(blocks[k].p, SIZET);
+		blocks[k] = node();
+		if(k == first)
+			++first;
+		else if(k + 1 == last)
+			--last;
+		else
+		{
+			std::copy(blocks.begin() + k + 1, blocks.begin() + last, blocks.begin() + k);
+			blocks[--last] = node();
+			index();
+		}
+	}
+
+	///
+	/// @param lo - the offset of the first element in the new inner array
+	/// @return a new node with an empty inner array
+	///
+	node make (size_type lo)
+	{
+		node x;
+		x.p = _a.allocate(SIZET);
+		x.lo = lo;
+		x.hi = lo;
+		return x;
+	}
+
+	///
+	/// Move the upper half of a full inner array into a new inner array in the next slot
+	/// @param k - a slot in use whose inner array is full
+	///
+	void split (size_type k)
+	{
+		node x = make(0);
+		size_type j = open(k + 1);
+		k = j - 1;
+		node& y = blocks[k];
+		size_type mid = y.lo + y.size() / 2;
+		for(size_type i = mid; i != y.hi; ++i, ++x.hi)
+		{
+			std::allocator_traits<A>::construct(_a, x.p + x.hi, y.p[i]);
+			std::allocator_traits<A>::destroy(_a, y.p + i);
+		}
+		y.hi = mid;
+		blocks[j] = x;
+		index();
+	}
+
+	///
+	/// Merge the inner array of slot k + 1 into the inner array of slot k
+	/// @param k - a slot in use such that k + 1 is also in use and their elements fit into one inner array
+	///
+	void merge (size_type k)
+	{
+		node& x = blocks[k];
+		node& y = blocks[k + 1];
+		assert(x.size() + y.size() <= USIZET);
+		if(x.hi + y.size() > USIZET)
+		{
+			// make room after the elements of x
+			for(size_type i = 0; i != x.size(); ++i)
+			{
+				std::allocator_traits<A>::construct(_a, x.p + i, x.p[x.lo + i]);
+				std::allocator_traits<A>::destroy(_a, x.p + x.lo + i);
+			}
+			x.hi -= x.lo;
+			x.lo = 0;
+		}
+		size_type n = y.size();
+		for(size_type i = y.lo; i != y.hi; ++i, ++x.hi)
+		{
+			std::allocator_traits<A>::construct(_a, x.p + x.hi, y.p[i]);
+			std::allocator_traits<A>::destroy(_a, y.p + i);
+		}
+		y.lo = y.hi;
+		add(k, n);
+		add(k + 1, -static_cast<difference_type>(n));
+		close(k + 1);
+	}
+
+	///
+	/// Destroy all elements and free all inner arrays
+	///
+	void destroy ()
+	{
+		for(size_type k = first; k != last; ++k)
+		{
+			for(size_type i = blocks[k].lo; i != blocks[k].hi; ++i)
+				std::allocator_traits<A>::destroy(_a, blocks[k].p + i);
+			_a.deallocate(blocks[k].p, SIZET);
+		}
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty RopeDeque container
+	* @param a - allocator object
+	*/
+	explicit RopeDeque (const allocator_type& a = allocator_type()) : _a (a), first (0), last (0), count (0)
+	{
+		assert(valid());
+	}
+
+	/**
+	* Create a RopeDeque container with s elements, each of them a copy of v
+	* @param s - the # of elements
+	* @param v - value to fill the container with
+	* @param a - allocator object
+	*/
+	explicit RopeDeque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) :
+		_a (a), first (0), last (0), count (0)
+	{
+		for(size_type i = 0; i != s; ++i)
+			push_back(v);
+		assert(valid());
+	}
+
+	/**
+	* Copy Constructor
+	* @param that - a RopeDeque container of the same type
+	*/
+	RopeDeque (const RopeDeque& that) : _a (that._a), first (0), last (0), count (0)
+	{
+		that.for_each_segment(0, that.size(), [this] (const_pointer b, const_pointer e)
+		{
+			while(b != e)
+				push_back(*b++);
+		});
+		assert(valid());
+	}
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Destroys all elements and frees all inner arrays
+	*/
+	~RopeDeque ()
+	{
+		destroy();
+	}
+
+	// ----------
+	// operator =
+	// ----------
+
+	/**
+	* Copy Assignment Operator
+	* @param rhs - a RopeDeque container of the same type
+	* @return a reference to the RopeDeque container
+	*/
+	RopeDeque& operator = (const RopeDeque& rhs)
+	{
+		if(this != &rhs)
+		{
+			RopeDeque x(rhs);
+			swap(x);
+		}
+		assert(valid());
+		return *this;
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	*/
+	reference operator [] (size_type index)
+	{
+		std::pair<size_type, size_type> x = locate(index);
+		return blocks[x.first].p[blocks[x.first].lo + x.second];
+	}
+
+	/**
+	* const subscript operator
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return const_cast<RopeDeque*>(this)->operator[](index);
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns a reference to the element at position index in the RopeDeque container object
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the RopeDeque container
+	*/
+	reference at (size_type index)
+	{
+		if (index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	/**
+	* Returns a const reference to the element at position index in the RopeDeque container object
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the RopeDeque container
+	*/
+	const_reference at (size_type index) const
+	{
+		return const_cast<RopeDeque*>(this)->at(index);
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return a reference to the last element of the RopeDeque container
+	*/
+	reference back ()
+	{
+		assert(!empty());
+		return blocks[last - 1].p[blocks[last - 1].hi - 1];
+	}
+
+	/**
+	* Access last element
+	* @return a const reference to the last element of the RopeDeque container
+	*/
+	const_reference back () const
+	{
+		return const_cast<RopeDeque*>(this)->back();
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return an Iterator to the beginning of the RopeDeque container
+	*/
+	iterator begin ()
+	{
+		return iterator(this, 0);
+	}
+
+	/**
+	* @return a Const Iterator to the beginning of the RopeDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all elements of the RopeDeque container and free its inner arrays
+	*/
+	void clear ()
+	{
+		destroy();
+		blocks.clear();
+		tree.clear();
+		first = last = count = 0;
+		assert(valid());
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the RopeDeque container is empty
+	* @return true if the RopeDeque container contains zero elements
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return an Iterator to the end of the RopeDeque container
+	*/
+	iterator end ()
+	{
+		return iterator(this, size());
+	}
+
+	/**
+	* @return a Const Iterator to the end of the RopeDeque container
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// -----
+	// erase
+	// -----
+
+	/**
+	* Remove an element, shifting the shorter side of its inner array, and merge the inner array with the next one
+	* when both are at most a quarter full
+	* @param i - an Iterator to the element
+	* @return an Iterator to the element after the removed one
+	*/
+	iterator erase (iterator i)
+	{
+		size_type index = i.index();
+		assert(index < count);
+		std::pair<size_type, size_type> x = locate(index);
+		size_type k = x.first;
+		node& y = blocks[k];
+		pointer p = y.p + y.lo + x.second;
+		if(x.second < y.size() / 2)
+		{
+			std::copy_backward(y.p + y.lo, p, p + 1);
+			std::allocator_traits<A>::destroy(_a, y.p + y.lo);
+			++y.lo;
+		}
+		else
+		{
+			std::copy(p + 1, y.p + y.hi, p);
+			std::allocator_traits<A>::destroy(_a, y.p + y.hi - 1);
+			--y.hi;
+		}
+		add(k, -1);
+		--count;
+		if(y.size() == 0)
+			close(k);
+		else if(k + 1 < last && y.size() + blocks[k + 1].size() <= USIZET / 2)
+			merge(k);
+		else if(k > first && y.size() + blocks[k - 1].size() <= USIZET / 2)
+			merge(k - 1);
+		assert(valid());
+		return iterator(this, index);
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return a reference to the first element of the RopeDeque container
+	*/
+	reference front ()
+	{
+		assert(!empty());
+		return blocks[first].p[blocks[first].lo];
+	}
+
+	/**
+	* Access first element
+	* @return a const reference to the first element of the RopeDeque container
+	*/
+	const_reference front () const
+	{
+		return const_cast<RopeDeque*>(this)->front();
+	}
+
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array
+	* @tparam F - a function object taking a pointer to the beginning and a pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f)
+	{
+		assert(i <= j && j <= count);
+		if(i == j)
+			return f;
+		std::pair<size_type, size_type> x = locate(i);
+		for(size_type k = x.first, o = x.second; i < j; ++k, o = 0)
+		{
+			pointer b = blocks[k].p + blocks[k].lo + o;
+			size_type n = std::min(blocks[k].size() - o, j - i);
+			f(b, b + n);
+			i += n;
+		}
+		return f;
+	}
+
+	/**
+	* Call a function on each contiguous segment of the elements [i, j), one per inner array
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a segment
+	* @param i - the index of the first element
+	* @param j - the index one past the last element
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j && j <= count);
+		if(i == j)
+			return f;
+		std::pair<size_type, size_type> x = locate(i);
+		for(size_type k = x.first, o = x.second; i < j; ++k, o = 0)
+		{
+			const_pointer b = blocks[k].p + blocks[k].lo + o;
+			size_type n = std::min(blocks[k].size() - o, j - i);
+			f(b, b + n);
+			i += n;
+		}
+		return f;
+	}
+
+	// ------
+	// insert
+	// ------
+
+	/**
+	* Insert an element before an Iterator, splitting its inner array in two when it is full
+	* @param i - an Iterator to the position of the new element
+	* @param v - a const reference to the value of the new element
+	* @return an Iterator to the new element
+	*/
+	iterator insert (iterator i, const_reference v)
+	{
+		size_type index = i.index();
+		assert(index <= count);
+		if(index == count)
+		{
+			push_back(v);
+			return iterator(this, index);
+		}
+		if(index == 0)
+		{
+			push_front(v);
+			return begin();
+		}
+		// v may be an element of the container, which the shifts below overwrite
+		value_type w = v;
+		std::pair<size_type, size_type> x = locate(index);
+		if(blocks[x.first].size() == USIZET)
+		{
+			split(x.first);
+			x = locate(index);
+		}
+		node& y = blocks[x.first];
+		pointer p = y.p + y.lo + x.second;
+		if(y.hi < USIZET && (y.lo == 0 || x.second >= y.size() / 2))
+		{
+			pointer e = y.p + y.hi;
+			std::allocator_traits<A>::construct(_a, e, *(e - 1));
+			std::copy_backward(p, e - 1, e);
+			++y.hi;
+		}
+		else
+		{
+			// the element goes before p, so the elements before it move down one slot
+			pointer b = y.p + y.lo;
+			std::allocator_traits<A>::construct(_a, b - 1, (p == b) ? w : *b);
+			std::copy(b + 1, p, b);
+			--p;
+			--y.lo;
+		}
+		*p = w;
+		add(x.first, 1);
+		++count;
+		assert(valid());
+		return iterator(this, index);
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last element of the RopeDeque container
+	*/
+	void pop_back ()
+	{
+		assert(!empty());
+		node& x = blocks[last - 1];
+		std::allocator_traits<A>::destroy(_a, x.p + --x.hi);
+		add(last - 1, -1);
+		--count;
+		if(x.size() == 0)
+			close(last - 1);
+		assert(valid());
+	}
+
+	/**
+	* Delete the first element of the RopeDeque container
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		node& x = blocks[first];
+		std::allocator_traits<A>::destroy(_a, x.p + x.lo++);
+		add(first, -1);
+		--count;
+		if(x.size() == 0)
+			close(first);
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the RopeDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_back (const_reference v)
+	{
+		if(first == last || blocks[last - 1].hi == USIZET)
+		{
+			if(last == blocks.size())
+				rebuild(1);
+			blocks[last++] = make(0);
+		}
+		node& x = blocks[last - 1];
+		std::allocator_traits<A>::construct(_a, x.p + x.hi, v);
+		++x.hi;
+		add(last - 1, 1);
+		++count;
+		assert(valid());
+	}
+
+	/**
+	* Add element to the front of the RopeDeque container
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_front (const_reference v)
+	{
+		if(first == last || blocks[first].lo == 0)
+		{
+			if(first == 0)
+				rebuild(1);
+			blocks[--first] = make(SIZET);
+		}
+		node& x = blocks[first];
+		std::allocator_traits<A>::construct(_a, x.p + x.lo - 1, v);
+		--x.lo;
+		add(first, 1);
+		++count;
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of elements in the RopeDeque container
+	*/
+	size_type size () const
+	{
+		return count;
+	}
+
+	// ----
+	// swap
+	// ----
+
+	/**
+	* Exchange the contents of two RopeDeque containers
+	* @param that - a RopeDeque container of the same type
+	*/
+	void swap (RopeDeque& that)
+	{
+		std::swap(_a, that._a);
+		std::swap(blocks, that.blocks);
+		std::swap(tree, that.tree);
+		std::swap(first, that.first);
+		std::swap(last, that.last);
+		std::swap(count, that.count);
+		assert(valid());
+	}
+};
+
+#endif // RopeDeque_h
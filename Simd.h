@@ -0,0 +1,393 @@
+// ------
+// Simd.h
+// ------
+
+#ifndef Simd_h
+#define Simd_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // count, find, max_element, min_element
+#include <cstddef>   // size_t
+#include <numeric>   // accumulate
+
+#include "Deque.h"   // MyDeque
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DEQUE_X86 1
+#include <immintrin.h>
+#endif
+
+// ----
+// simd
+// ----
+
+///
+/// Searching and reducing kernels over MyDeque containers
+/// Each kernel runs over the contiguous segment of every inner array, using AVX2 or SSE4.1 for int and float elements
+/// when the CPU supports them, and the standard algorithms otherwise. Float kernels do not support NaNs, and accumulate
+/// adds float elements in a different order than std::accumulate.
+///
+namespace simd
+{
+	///
+	/// The instruction sets the kernels can use
+	///
+	enum isa { scalar, sse41, avx2 };
+
+	///
+	/// @return the instruction set the kernels use, which is the best one the CPU supports unless it is changed
+	///
+	inline isa& active ()
+	{
+		#ifdef DEQUE_X86
+		static isa x = __builtin_cpu_supports("avx2") ? avx2 : __builtin_cpu_supports("sse4.1") ? sse41 : scalar;
+		#else
+		static isa x = scalar;
+		#endif
+		return x;
+	}
+
+	namespace detail
+	{
+		// -------------------
+		// reduction operations
+		// -------------------
+
+		///
+		/// Reduction operations on elements; each vector type combines its vectors with the same operations
+		///
+		struct min_op
+		{
+			template <typename T>
+			static T apply (const T& x, const T& y) {return (y < x) ? y : x;}
+		};
+
+		struct max_op
+		{
+			template <typename T>
+			static T apply (const T& x, const T& y) {return (x < y) ? y : x;}
+		};
+
+		struct add_op
+		{
+			template <typename T>
+			static T apply (const T& x, const T& y) {return x + y;}
+		};
+
+		#ifdef DEQUE_X86
+
+		#define DEQUE_AVX2  __attribute__((target("avx2")))
+		#define DEQUE_SSE41 __attribute__((target("sse4.1")))
+
+		// ------------
+		// vector types
+		// ------------
+
+		struct avx2_int
+		{
+			typedef int value_type;
+			typedef __m256i vector;
+			static const int width = 8;
+			DEQUE_AVX2 static vector load (const int* p) {return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));}
+			DEQUE_AVX2 static void store (int* p, vector x) {_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);}
+			DEQUE_AVX2 static vector set1 (int v) {return _mm256_set1_epi32(v);}
+			DEQUE_AVX2 static int eq (vector x, vector y) {return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y)));}
+			DEQUE_AVX2 static vector combine (min_op, vector x, vector y) {return _mm256_min_epi32(x, y);}
+			DEQUE_AVX2 static vector combine (max_op, vector x, vector y) {return _mm256_max_epi32(x, y);}
+			DEQUE_AVX2 static vector combine (add_op, vector x, vector y) {return _mm256_add_epi32(x, y);}
+		};
+
+		struct avx2_float
+		{
+			typedef float value_type;
+			typedef __m256 vector;
+			static const int width = 8;
+			DEQUE_AVX2 static vector load (const float* p) {return _mm256_loadu_ps(p);}
+			DEQUE_AVX2 static void store (float* p, vector x) {_mm256_storeu_ps(p, x);}
+			DEQUE_AVX2 static vector set1 (float v) {return _mm256_set1_ps(v);}
+			DEQUE_AVX2 static int eq (vector x, vector y) {return _mm256_movemask_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ));}
+			DEQUE_AVX2 static vector combine (min_op, vector x, vector y) {return _mm256_min_ps(x, y);}
+			DEQUE_AVX2 static vector combine (max_op, vector x, vector y) {return _mm256_max_ps(x, y);}
+			DEQUE_AVX2 static vector combine (add_op, vector x, vector y) {return _mm256_add_ps(x, y);}
+		};
+
+		struct sse41_int
+		{
+			typedef int value_type;
+			typedef __m128i vector;
+			static const int width = 4;
+			DEQUE_SSE41 static vector load (const int* p) {return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));}
+			DEQUE_SSE41 static void store (int* p, vector x) {_mm_storeu_si128(reinterpret_cast<__m128i*>(p), x);}
+			DEQUE_SSE41 static vector set1 (int v) {return _mm_set1_epi32(v);}
+			DEQUE_SSE41 static int eq (vector x, vector y) {return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y)));}
+			DEQUE_SSE41 static vector combine (min_op, vector x, vector y) {return _mm_min_epi32(x, y);}
+			DEQUE_SSE41 static vector combine (max_op, vector x, vector y) {return _mm_max_epi32(x, y);}
+			DEQUE_SSE41 static vector combine (add_op, vector x, vector y) {return _mm_add_epi32(x, y);}
+		};
+
+		struct sse41_float
+		{
+			typedef float value_type;
+			typedef __m128 vector;
+			static const int width = 4;
+			DEQUE_SSE41 static vector load (const float* p) {return _mm_loadu_ps(p);}
+			DEQUE_SSE41 static void store (float* p, vector x) {_mm_storeu_ps(p, x);}
+			DEQUE_SSE41 static vector set1 (float v) {return _mm_set1_ps(v);}
+			DEQUE_SSE41 static int eq (vector x, vector y) {return _mm_movemask_ps(_mm_cmpeq_ps(x, y));}
+			DEQUE_SSE41 static vector combine (min_op, vector x, vector y) {return _mm_min_ps(x, y);}
+			DEQUE_SSE41 static vector combine (max_op, vector x, vector y) {return _mm_max_ps(x, y);}
+			DEQUE_SSE41 static vector combine (add_op, vector x, vector y) {return _mm_add_ps(x, y);}
+		};
+
+		// -------
+		// kernels
+		// -------
+
+		// The kernels are written once over a vector type V and compiled for each instruction set with its target
+		// attribute, so that they and the operations of V pass vectors in the same registers.
+		#define DEQUE_KERNELS(S, ATTRIBUTE) \
+			template <typename V> \
+			ATTRIBUTE const typename V::value_type* find_##S (const typename V::value_type* b, const typename V::value_type* e, typename V::value_type v) \
+			{ \
+				typename V::vector x = V::set1(v); \
+				for(; e - b >= V::width; b += V::width) \
+				{ \
+					int m = V::eq(V::load(b), x); \
+					if(m != 0) \
+						return b + __builtin_ctz(m); \
+				} \
+				return std::find(b, e, v); \
+			} \
+			\
+			template <typename V> \
+			ATTRIBUTE std::size_t count_##S (const typename V::value_type* b, const typename V::value_type* e, typename V::value_type v) \
+			{ \
+				typename V::vector x = V::set1(v); \
+				std::size_t n = 0; \
+				for(; e - b >= V::width; b += V::width) \
+					n += __builtin_popcount(V::eq(V::load(b), x)); \
+				return n + std::count(b, e, v); \
+			} \
+			\
+			template <typename V, typename Op> \
+			ATTRIBUTE typename V::value_type reduce_##S (const typename V::value_type* b, const typename V::value_type* e, typename V::value_type init, Op) \
+			{ \
+				typename V::value_type a[V::width]; \
+				if(e - b >= V::width) \
+				{ \
+					typename V::vector x = V::load(b); \
+					for(b += V::width; e - b >= V::width; b += V::width) \
+						x = V::combine(Op(), x, V::load(b)); \
+					V::store(a, x); \
+					for(int i = 0; i < V::width; ++i) \
+						init = Op::apply(init, a[i]); \
+				} \
+				for(; b != e; ++b) \
+					init = Op::apply(init, *b); \
+				return init; \
+			}
+
+		DEQUE_KERNELS(avx2, DEQUE_AVX2)
+		DEQUE_KERNELS(sse41, DEQUE_SSE41)
+
+		#undef DEQUE_KERNELS
+		#undef DEQUE_AVX2
+		#undef DEQUE_SSE41
+
+		// The int and float overloads of the span functions dispatch on the active instruction set
+		#define DEQUE_DISPATCH(T, NAME, R, AVX2, SSE41, SCALAR) \
+			inline R NAME##_span (const T* b, const T* e, T v) \
+			{ \
+				switch(active()) \
+				{ \
+					case avx2: return AVX2; \
+					case sse41: return SSE41; \
+					default: return SCALAR; \
+				} \
+			}
+
+		#else
+
+		#define DEQUE_DISPATCH(T, NAME, R, AVX2, SSE41, SCALAR) \
+			inline R NAME##_span (const T* b, const T* e, T v) \
+			{ \
+				return SCALAR; \
+			}
+
+		#endif
+
+		// ----------
+		// span scans
+		// ----------
+
+		template <typename T>
+		const T* find_span (const T* b, const T* e, const T& v) {return std::find(b, e, v);}
+		template <typename T>
+		std::size_t count_span (const T* b, const T* e, const T& v) {return std::count(b, e, v);}
+		template <typename T>
+		T min_span (const T* b, const T* e, const T& v) {return std::min(v, *std::min_element(b, e));}
+		template <typename T>
+		T max_span (const T* b, const T* e, const T& v) {return std::max(v, *std::max_element(b, e));}
+		template <typename T>
+		T sum_span (const T* b, const T* e, const T& v) {return std::accumulate(b, e, v);}
+
+		DEQUE_DISPATCH(int, find, const int*, find_avx2<avx2_int>(b, e, v), find_sse41<sse41_int>(b, e, v), std::find(b, e, v))
+		DEQUE_DISPATCH(int, count, std::size_t, count_avx2<avx2_int>(b, e, v), count_sse41<sse41_int>(b, e, v), std::count(b, e, v))
+		DEQUE_DISPATCH(int, min, int, reduce_avx2<avx2_int>(b, e, v, min_op()), reduce_sse41<sse41_int>(b, e, v, min_op()), min_op::apply(v, *std::min_element(b, e)))
+		DEQUE_DISPATCH(int, max, int, reduce_avx2<avx2_int>(b, e, v, max_op()), reduce_sse41<sse41_int>(b, e, v, max_op()), max_op::apply(v, *std::max_element(b, e)))
+		DEQUE_DISPATCH(int, sum, int, reduce_avx2<avx2_int>(b, e, v, add_op()), reduce_sse41<sse41_int>(b, e, v, add_op()), std::accumulate(b, e, v))
+		DEQUE_DISPATCH(float, find, const float*, find_avx2<avx2_float>(b, e, v), find_sse41<sse41_float>(b, e, v), std::find(b, e, v))
+		DEQUE_DISPATCH(float, count, std::size_t, count_avx2<avx2_float>(b, e, v), count_sse41<sse41_float>(b, e, v), std::count(b, e, v))
+		DEQUE_DISPATCH(float, min, float, reduce_avx2<avx2_float>(b, e, v, min_op()), reduce_sse41<sse41_float>(b, e, v, min_op()), min_op::apply(v, *std::min_element(b, e)))
+		DEQUE_DISPATCH(float, max, float, reduce_avx2<avx2_float>(b, e, v, max_op()), reduce_sse41<sse41_float>(b, e, v, max_op()), max_op::apply(v, *std::max_element(b, e)))
+		DEQUE_DISPATCH(float, sum, float, reduce_avx2<avx2_float>(b, e, v, add_op()), reduce_sse41<sse41_float>(b, e, v, add_op()), std::accumulate(b, e, v))
+
+		#undef DEQUE_DISPATCH
+
+		///
+		/// Find the first smallest or largest element of a MyDeque container in one pass
+		/// Each segment is reduced once; only the segment holding the extreme is scanned again, to find its position.
+		/// @param x - a MyDeque container
+		/// @param largest - true to find the largest element instead of the smallest
+		/// @return the index of the element, or 0 if the container is empty
+		///
+		template <typename T, typename A>
+		typename MyDeque<T, A>::size_type extreme_index (const MyDeque<T, A>& x, bool largest)
+		{
+			typedef typename MyDeque<T, A>::template segment_view<const MyDeque<T, A>, typename MyDeque<T, A>::const_pointer> view;
+			if(x.empty())
+				return 0;
+			view s = x.segments();
+			typename MyDeque<T, A>::size_type i = 0;
+			typename MyDeque<T, A>::size_type k = 0; // the index of the segment holding the extreme
+			typename MyDeque<T, A>::size_type n = 0; // its # of elements
+			T m = x.front();
+			for(typename view::iterator j = s.begin(); j != s.end(); ++j)
+			{
+				typename view::value_type r = *j;
+				T v = largest ? max_span(r.first, r.first + r.second, *r.first) : min_span(r.first, r.first + r.second, *r.first);
+				if(n == 0 || (largest ? (m < v) : (v < m)))
+				{
+					m = v;
+					k = i;
+					n = r.second;
+				}
+				i += r.second;
+			}
+			// A MyDeque container with a memory budget may have spilled the segment since, so it is read again by index
+			const T* p = &x[k];
+			return k + (find_span(p, p + n, m) - p);
+		}
+	}
+
+	// -----
+	// count
+	// -----
+
+	/**
+	* Count the elements of a MyDeque container equal to a value
+	* @param x - a MyDeque container
+	* @param v - the value
+	* @return the number of elements equal to v
+	*/
+	template <typename T, typename A>
+	typename MyDeque<T, A>::size_type count (const MyDeque<T, A>& x, const T& v)
+	{
+		typename MyDeque<T, A>::size_type n = 0;
+		x.for_each_segment(0, x.size(), [&] (const T* b, const T* e) {n += detail::count_span(b, e, v);});
+		return n;
+	}
+
+	// ----
+	// find
+	// ----
+
+	/**
+	* Find the first element of a MyDeque container equal to a value
+	* The scan stops at the segment holding the match, so a MyDeque container with a memory budget does not load the rest.
+	* @param x - a MyDeque container
+	* @param v - the value
+	* @return a Const Iterator to the first element equal to v, or end() if there is none
+	*/
+	template <typename T, typename A>
+	typename MyDeque<T, A>::const_iterator find (const MyDeque<T, A>& x, const T& v)
+	{
+		typedef typename MyDeque<T, A>::template segment_view<const MyDeque<T, A>, typename MyDeque<T, A>::const_pointer> view;
+		view s = x.segments();
+		typename MyDeque<T, A>::size_type i = 0;
+		for(typename view::iterator j = s.begin(); j != s.end(); ++j)
+		{
+			typename view::value_type r = *j;
+			const T* p = detail::find_span(r.first, r.first + r.second, v);
+			i += p - r.first;
+			if(p != r.first + r.second)
+				break;
+		}
+		return typename MyDeque<T, A>::const_iterator(&x, i);
+	}
+
+	// --------
+	// contains
+	// --------
+
+	/**
+	* @param x - a MyDeque container
+	* @param v - a value
+	* @return true if an element of the MyDeque container is equal to v
+	*/
+	template <typename T, typename A>
+	bool contains (const MyDeque<T, A>& x, const T& v)
+	{
+		return find(x, v) != x.end();
+	}
+
+	// -----------
+	// min_element
+	// -----------
+
+	/**
+	* @param x - a MyDeque container
+	* @return a Const Iterator to the first smallest element, or end() if the container is empty
+	*/
+	template <typename T, typename A>
+	typename MyDeque<T, A>::const_iterator min_element (const MyDeque<T, A>& x)
+	{
+		return typename MyDeque<T, A>::const_iterator(&x, detail::extreme_index(x, false));
+	}
+
+	// -----------
+	// max_element
+	// -----------
+
+	/**
+	* @param x - a MyDeque container
+	* @return a Const Iterator to the first largest element, or end() if the container is empty
+	*/
+	template <typename T, typename A>
+	typename MyDeque<T, A>::const_iterator max_element (const MyDeque<T, A>& x)
+	{
+		return typename MyDeque<T, A>::const_iterator(&x, detail::extreme_index(x, true));
+	}
+
+	// ----------
+	// accumulate
+	// ----------
+
+	/**
+	* Add the elements of a MyDeque container
+	* @param x - a MyDeque container
+	* @param init - the initial value of the sum
+	* @return init plus every element
+	*/
+	template <typename T, typename A>
+	T accumulate (const MyDeque<T, A>& x, T init)
+	{
+		x.for_each_segment(0, x.size(), [&] (const T* b, const T* e) {init = detail::sum_span(b, e, init);});
+		return init;
+	}
+}
+
+#endif // Simd_h
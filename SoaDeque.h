@@ -0,0 +1,724 @@
+// ----------
+// SoaDeque.h
+// ----------
+
+#ifndef SoaDeque_h
+#define SoaDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // equal, lexicographical_compare, min, swap
+#include <cassert>   // assert
+#include <cstddef>   // ptrdiff_t, size_t
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // out_of_range
+#include <tuple>     // get, tuple, tuple_element
+#include <type_traits> // integral_constant
+#include <vector>    // vector
+
+#include "Deque.h"    // SIZET, USIZET
+#include "Iterator.h" // IndexIterator
+
+// -----------
+// soa_indices
+// -----------
+
+///
+/// The indices 0 to N - 1 of the columns of a SoaDeque as a parameter pack, which C++11 lacks as std::index_sequence
+///
+template <std::size_t... I>
+struct soa_indices
+{};
+
+template <std::size_t N, std::size_t... I>
+struct soa_make_indices : soa_make_indices<N - 1, N - 1, I...>
+{};
+
+template <std::size_t... I>
+struct soa_make_indices<0, I...>
+{
+	typedef soa_indices<I...> type;
+};
+
+// -------------
+// BasicSoaDeque
+// -------------
+
+///
+/// A deque of records stored as a structure of arrays: each field of the records has its own inner arrays
+/// One outer array holds, for each block of SIZET records, a pointer to the inner array of every column, so the columns share
+/// the circular outer array and the b offset bookkeeping of MyDeque; a scan of one column reads only that column's inner arrays.
+/// operator [] returns a tuple of references to the fields of a record, which can be read, assigned or assigned to as a whole.
+/// @tparam A - Type of Allocator object used to define the storage allocation model, rebound to the type of each column
+/// @tparam Ts - Types of the fields of a record
+///
+template <typename A, typename... Ts>
+class BasicSoaDeque
+{
+	static_assert(sizeof...(Ts) > 0, "SoaDeque requires at least one column");
+
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef std::tuple<Ts...>        value_type;
+	typedef A                        allocator_type;
+
+	typedef std::size_t              size_type;
+	typedef std::ptrdiff_t           difference_type;
+
+	typedef void                     pointer;
+	typedef void                     const_pointer;
+
+	typedef std::tuple<Ts&...>       reference;
+	typedef std::tuple<const Ts&...> const_reference;
+
+	typedef IndexIterator<BasicSoaDeque, value_type, reference, pointer>                   iterator;
+	typedef IndexIterator<const BasicSoaDeque, value_type, const_reference, const_pointer> const_iterator;
+
+	///
+	/// The type of column I
+	///
+	template <std::size_t I>
+	struct column
+	{
+		typedef typename std::tuple_element<I, value_type>::type type;
+	};
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side SoaDeque
+	* @param rhs - the right hand side SoaDeque
+	* @return true if the lhs SoaDeque is equal to the rhs SoaDeque
+	*/
+	friend bool operator == (const BasicSoaDeque& lhs, const BasicSoaDeque& rhs)
+	{
+		return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side SoaDeque
+	* @param rhs - the right hand side SoaDeque
+	* @return true if the lhs SoaDeque is lexicographically less than the rhs SoaDeque
+	*/
+	friend bool operator < (const BasicSoaDeque& lhs, const BasicSoaDeque& rhs)
+	{
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+private:
+	typedef typename soa_make_indices<sizeof...(Ts)>::type indices;
+	typedef std::tuple<Ts*...> blocks;
+	typedef std::tuple<typename std::allocator_traits<A>::template rebind_alloc<Ts>...> allocators;
+
+	///
+	/// The allocator traits of column I
+	///
+	template <std::size_t I>
+	struct traits : std::allocator_traits<typename std::tuple_element<I, allocators>::type>
+	{};
+
+	// ----
+	// data
+	// ----
+
+	std::vector<blocks> map; // the circular outer array, with the inner arrays of every column for each block
+	size_type head;          // the slot of the first block
+	size_type b;             // the offset of the first record in the first block
+	size_type count;         // the # of records
+	allocators _a;           // the allocator of each column
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the SoaDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		if(map.empty())
+			return head == 0 && b == 0 && count == 0;
+		return (head < map.size()) && (b < USIZET) && (b + count <= map.size() * USIZET);
+	}
+
+	///
+	/// Find the inner arrays of a block of the circular outer array
+	/// @param k - the number of blocks after the first block
+	/// @return the inner arrays of every column of the block
+	///
+	blocks& block (size_type k)
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	const blocks& block (size_type k) const
+	{
+		return map[(head + k) % map.size()];
+	}
+
+	///
+	/// Call a function object on each column
+	/// The function object is called as f.template apply<I>() for each column I.
+	///
+	template <typename F, std::size_t... I>
+	static void each (F f, soa_indices<I...>)
+	{
+		int x[] = {(f.template apply<I>(), 0)...};
+		(void) x;
+	}
+
+	///
+	/// Allocate the inner arrays of a block that has none
+	/// If a column throws, the inner arrays already allocated stay in the block, which frees them with the others.
+	///
+	struct allocate
+	{
+		blocks& x;
+		allocators& a;
+		template <std::size_t I>
+		void apply () const
+		{
+			if(std::get<I>(x) == nullptr)
+				std::get<I>(x) = &*traits<I>::allocate(std::get<I>(a), SIZET);
+		}
+	};
+
+	///
+	/// Free the inner arrays of a block
+	///
+	struct deallocate
+	{
+		blocks& x;
+		allocators& a;
+		template <std::size_t I>
+		void apply () const
+		{
+			if(std::get<I>(x) != nullptr)
+				traits<I>::deallocate(std::get<I>(a), std::get<I>(x), SIZET);
+		}
+	};
+
+	///
+	/// Destroy the fields of the record in the slot o of a block
+	///
+	struct destroy
+	{
+		blocks& x;
+		allocators& a;
+		size_type o;
+		template <std::size_t I>
+		void apply () const
+		{
+			traits<I>::destroy(std::get<I>(a), std::get<I>(x) + o);
+		}
+	};
+
+	///
+	/// Copy construct the fields of a record into the slot o of a block, from column I on
+	/// If a field throws, the fields of the columns before it are destroyed before the exception propagates.
+	/// @param x - the inner arrays of the block
+	/// @param o - the slot of the record in the block
+	/// @param v - the record
+	///
+	void construct (blocks&, size_type, const value_type&, std::integral_constant<std::size_t, sizeof...(Ts)>)
+	{}
+
+	template <std::size_t I>
+	void construct (blocks& x, size_type o, const value_type& v, std::integral_constant<std::size_t, I>)
+	{
+		traits<I>::construct(std::get<I>(_a), std::get<I>(x) + o, std::get<I>(v));
+		try
+		{
+			construct(x, o, v, std::integral_constant<std::size_t, I + 1>());
+		}
+		catch(...)
+		{
+			traits<I>::destroy(std::get<I>(_a), std::get<I>(x) + o);
+			throw;
+		}
+	}
+
+	///
+	/// @param x - the inner arrays of a block
+	/// @param o - the slot of a record in the block
+	/// @return a tuple of references to the fields of the record
+	///
+	template <std::size_t... I>
+	static reference fields (const blocks& x, size_type o, soa_indices<I...>)
+	{
+		return reference(std::get<I>(x)[o]...);
+	}
+
+	///
+	/// Move the blocks in use to the middle of a larger circular outer array, in order, followed by the unused blocks
+	/// @param s - the minimum # of records of the new outer array
+	///
+	void rebuild (size_type s)
+	{
+		assert(s >= count);
+		size_type outer = 2 * ((s + SIZET - 1) / SIZET) + 1;
+		assert(outer > map.size());
+		std::vector<blocks> x(outer, blocks());
+		size_type h = outer / 2;
+		for(size_type i = 0; i != map.size(); ++i)
+			x[(h + i) % outer] = block(i);
+		map.swap(x);
+		head = h;
+		assert(valid());
+	}
+
+	///
+	/// Construct a record in the slot of a record position, allocating its block if it has none
+	/// @param index - record position in the container
+	/// @param v - the record
+	///
+	void put (size_type index, const value_type& v)
+	{
+		blocks& x = block((b + index) / SIZET);
+		each(allocate {x, _a}, indices());
+		construct(x, (b + index) % SIZET, v, std::integral_constant<std::size_t, 0>());
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty SoaDeque container
+	* @param a - an optional argument for an allocator object, rebound to the type of each column
+	*/
+	explicit BasicSoaDeque (const A& a = A()) : head (0), b (0), count (0),
+		_a (typename std::allocator_traits<A>::template rebind_alloc<Ts>(a)...)
+	{
+		assert(valid());
+	}
+
+	/**
+	* Copy Constructor
+	* @param that - a SoaDeque container of the same type
+	*/
+	BasicSoaDeque (const BasicSoaDeque& that) : head (0), b (0), count (0), _a (that._a)
+	{
+		if(!that.empty())
+			rebuild(that.size());
+		for(size_type i = 0; i != that.size(); ++i)
+			push_back(that[i]);
+		assert(valid());
+	}
+
+	// ----------
+	// destructor
+	// ----------
+
+	/**
+	* Destructor - Destroys all records and frees all inner arrays
+	*/
+	~BasicSoaDeque ()
+	{
+		clear();
+		for(size_type i = 0; i != map.size(); ++i)
+			each(deallocate {map[i], _a}, indices());
+	}
+
+	// ----------
+	// operator =
+	// ----------
+
+	/**
+	* Copy Assignment Operator
+	* @param rhs - a SoaDeque container of the same type
+	* @return a reference to the SoaDeque container
+	*/
+	BasicSoaDeque& operator = (const BasicSoaDeque& rhs)
+	{
+		if(this != &rhs)
+		{
+			BasicSoaDeque x(rhs);
+			swap(x);
+		}
+		return *this;
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator
+	* @param index - record position in the container
+	* @return a tuple of references to the fields of the record
+	*/
+	reference operator [] (size_type index)
+	{
+		return fields(block((b + index) / SIZET), (b + index) % SIZET, indices());
+	}
+
+	/**
+	* const subscript operator
+	* @param index - record position in the container
+	* @return a tuple of const references to the fields of the record
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return const_cast<BasicSoaDeque*>(this)->operator[](index);
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns the fields of the record at position index in the SoaDeque container object
+	* @param index - record position in the container
+	* @return a tuple of references to the fields of the record
+	* @throws out_of_range exception if position index is not within the bounds of the SoaDeque container
+	*/
+	reference at (size_type index)
+	{
+		if (index >= size())
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	/**
+	* Returns the fields of the record at position index in the SoaDeque container object
+	* @param index - record position in the container
+	* @return a tuple of const references to the fields of the record
+	* @throws out_of_range exception if position index is not within the bounds of the SoaDeque container
+	*/
+	const_reference at (size_type index) const
+	{
+		return const_cast<BasicSoaDeque*>(this)->at(index);
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last record
+	* @return a tuple of references to the fields of the last record of the SoaDeque container
+	*/
+	reference back ()
+	{
+		assert(!empty());
+		return (*this)[count - 1];
+	}
+
+	/**
+	* Access last record
+	* @return a tuple of const references to the fields of the last record of the SoaDeque container
+	*/
+	const_reference back () const
+	{
+		return const_cast<BasicSoaDeque*>(this)->back();
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return an Iterator to the beginning of the SoaDeque container
+	*/
+	iterator begin ()
+	{
+		return iterator(this, 0);
+	}
+
+	/**
+	* @return a Const Iterator to the beginning of the SoaDeque container
+	*/
+	const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all records of the SoaDeque container; the inner arrays are kept
+	*/
+	void clear ()
+	{
+		while(!empty())
+			pop_back();
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the SoaDeque container is empty
+	* @return true if the SoaDeque container contains zero records
+	*/
+	bool empty () const
+	{
+		return !size();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return an Iterator to the end of the SoaDeque container
+	*/
+	iterator end ()
+	{
+		return iterator(this, size());
+	}
+
+	/**
+	* @return a Const Iterator to the end of the SoaDeque container
+	*/
+	const_iterator end () const
+	{
+		return const_iterator(this, size());
+	}
+
+	// ----------------
+	// for_each_segment
+	// ----------------
+
+	/**
+	* Call a function on each contiguous segment of column I over the records [i, j), one per inner array
+	* @tparam I - the column
+	* @tparam F - a function object taking a pointer to the beginning and a pointer to the end of a segment
+	* @param i - the index of the first record
+	* @param j - the index one past the last record
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <std::size_t I, typename F>
+	F for_each_segment (size_type i, size_type j, F f)
+	{
+		assert(i <= j && j <= count);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, j - i);
+			typename column<I>::type* x = std::get<I>(block((b + i) / SIZET)) + (b + i) % SIZET;
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	/**
+	* Call a function on each contiguous segment of column I over the records [i, j), one per inner array
+	* @tparam I - the column
+	* @tparam F - a function object taking a const pointer to the beginning and a const pointer to the end of a segment
+	* @param i - the index of the first record
+	* @param j - the index one past the last record
+	* @param f - the function object
+	* @return the function object
+	*/
+	template <std::size_t I, typename F>
+	F for_each_segment (size_type i, size_type j, F f) const
+	{
+		assert(i <= j && j <= count);
+		while(i < j)
+		{
+			size_type n = std::min<size_type>(SIZET - (b + i) % SIZET, j - i);
+			const typename column<I>::type* x = std::get<I>(block((b + i) / SIZET)) + (b + i) % SIZET;
+			f(x, x + n);
+			i += n;
+		}
+		return f;
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first record
+	* @return a tuple of references to the fields of the first record of the SoaDeque container
+	*/
+	reference front ()
+	{
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	/**
+	* Access first record
+	* @return a tuple of const references to the fields of the first record of the SoaDeque container
+	*/
+	const_reference front () const
+	{
+		return const_cast<BasicSoaDeque*>(this)->front();
+	}
+
+	// ---
+	// get
+	// ---
+
+	/**
+	* @tparam I - a column
+	* @param index - record position in the container
+	* @return a reference to field I of the record
+	*/
+	template <std::size_t I>
+	typename column<I>::type& get (size_type index)
+	{
+		return std::get<I>(block((b + index) / SIZET))[(b + index) % SIZET];
+	}
+
+	/**
+	* @tparam I - a column
+	* @param index - record position in the container
+	* @return a const reference to field I of the record
+	*/
+	template <std::size_t I>
+	const typename column<I>::type& get (size_type index) const
+	{
+		return const_cast<BasicSoaDeque*>(this)->template get<I>(index);
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last record of the SoaDeque container
+	*/
+	void pop_back ()
+	{
+		assert(!empty());
+		--count;
+		each(destroy {block((b + count) / SIZET), _a, (b + count) % SIZET}, indices());
+		assert(valid());
+	}
+
+	/**
+	* Delete the first record of the SoaDeque container
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		each(destroy {block(0), _a, b}, indices());
+		++b;
+		if(b == USIZET)
+		{
+			head = (head + 1) % map.size();
+			b = 0;
+		}
+		--count;
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add a record to the end of the SoaDeque container
+	* @param v - the record
+	*/
+	void push_back (const value_type& v)
+	{
+		if(b + count + 1 > map.size() * USIZET)
+		{
+			// v may be a record of the container, which stays put because rebuild moves only the outer array
+			rebuild(count + 1);
+		}
+		put(count, v);
+		++count;
+		assert(valid());
+	}
+
+	/**
+	* Add a record to the front of the SoaDeque container
+	* @param v - the record
+	*/
+	void push_front (const value_type& v)
+	{
+		if(map.empty() || (b == 0 && count + SIZET > map.size() * USIZET))
+			rebuild(count + 1);
+		size_type h = head;
+		size_type o = b;
+		if(b == 0)
+		{
+			head = (head + map.size() - 1) % map.size();
+			b = SIZET - 1;
+		}
+		else
+		{
+			--b;
+		}
+		try
+		{
+			put(0, v);
+		}
+		catch(...)
+		{
+			head = h;
+			b = o;
+			throw;
+		}
+		++count;
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of records in the SoaDeque container
+	*/
+	size_type size () const
+	{
+		return count;
+	}
+
+	// ----
+	// swap
+	// ----
+
+	/**
+	* Exchange the contents of two SoaDeque containers
+	* @param that - a SoaDeque container of the same type
+	*/
+	void swap (BasicSoaDeque& that)
+	{
+		map.swap(that.map);
+		std::swap(head, that.head);
+		std::swap(b, that.b);
+		std::swap(count, that.count);
+		std::swap(_a, that._a);
+	}
+};
+
+// --------
+// SoaDeque
+// --------
+
+///
+/// A BasicSoaDeque with the default allocator
+/// @tparam Ts - Types of the fields of a record
+///
+template <typename... Ts>
+using SoaDeque = BasicSoaDeque<std::allocator<std::tuple<Ts...> >, Ts...>;
+
+#endif // SoaDeque_h
@@ -0,0 +1,301 @@
+// -------
+// Spill.h
+// -------
+
+#ifndef Spill_h
+#define Spill_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>      // assert
+#include <cerrno>       // errno
+#include <cstddef>      // size_t
+#include <future>       // async, future
+#include <map>          // map
+#include <memory>       // allocator_traits
+#include <stdint.h>     // uintptr_t
+#include <system_error> // generic_category, system_error
+#include <utility>      // pair
+#include <vector>       // vector
+
+#include <fcntl.h>      // open
+#include <unistd.h>     // close, pread, pwrite, unlink
+
+// ----------
+// SpillStats
+// ----------
+
+///
+/// Counters of a SpillFile
+///
+struct SpillStats
+{
+	std::size_t spills;      // # of inner arrays written to the spill file
+	std::size_t fills;       // # of inner arrays read back from the spill file
+	std::size_t prefetches;  // # of fills started ahead of time on another thread
+	std::size_t stalls;      // # of fills that the MyDeque container waited for
+	std::size_t spill_bytes; // # of bytes written to the spill file
+	std::size_t fill_bytes;  // # of bytes read from the spill file
+};
+
+// ---------
+// SpillFile
+// ---------
+
+///
+/// A scratch file holding the inner arrays of a MyDeque container that is over its memory budget
+/// Each spilled inner array occupies one slot of the file, and the slots of filled inner arrays are reused.
+/// The file is unlinked as soon as it is created, so it disappears with the SpillFile.
+/// @tparam A - Type of the allocator of the inner arrays
+///
+template <typename A>
+class SpillFile
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef typename std::allocator_traits<A>::pointer   pointer;
+	typedef typename std::allocator_traits<A>::size_type size_type;
+
+private:
+	// ----
+	// data
+	// ----
+
+	A _a;
+	int fd;
+	size_type block_size;
+	size_type block_bytes;
+	size_type _budget;
+	size_type _resident;
+	size_type length;
+	std::vector<size_type> free_slots;
+	std::map<size_type, std::pair<pointer, std::future<bool> > > pending;
+	SpillStats _stats;
+
+private:
+	///
+	/// Throw a system_error exception for the last failed system call
+	/// @param what - the name of the failed system call
+	///
+	static void fail (const char* what)
+	{
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	///
+	/// Read an inner array from the spill file
+	/// @param fd - the spill file
+	/// @param p - the destination inner array
+	/// @param n - the # of bytes of an inner array
+	/// @param offset - the file offset of the inner array
+	/// @return true if the whole inner array was read
+	///
+	static bool read (int fd, pointer p, size_type n, size_type offset)
+	{
+		return pread(fd, p, n, offset) == static_cast<ssize_t>(n);
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty spill file
+	* @param path - the path of the spill file
+	* @param a - the allocator of the inner arrays
+	* @param s - the # of elements of an inner array
+	* @param n - the # of bytes of an inner array
+	* @param budget - the # of inner arrays that may be in memory
+	* @throws system_error exception if the file cannot be created
+	*/
+	SpillFile (const char* path, const A& a, size_type s, size_type n, size_type budget) :
+		_a (a), block_size (s), block_bytes (n), _budget (budget), _resident (0), length (0), _stats ()
+	{
+		fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+		if(fd < 0)
+			fail("open");
+		unlink(path);
+	}
+
+	SpillFile (const SpillFile&) = delete;
+	SpillFile& operator = (const SpillFile&) = delete;
+
+	/**
+	* Destructor - Waits for the fills in flight and frees their inner arrays
+	*/
+	~SpillFile ()
+	{
+		while(!pending.empty())
+			discard(pending.begin()->first);
+		close(fd);
+	}
+
+	// --------
+	// allocate
+	// --------
+
+	/**
+	* @return a new inner array that counts against the memory budget
+	*/
+	pointer allocate ()
+	{
+		pointer p = _a.allocate(block_size);
+		++_resident;
+		return p;
+	}
+
+	/**
+	* Free an inner array that counts against the memory budget
+	* @param p - the inner array
+	*/
+	void release (pointer p)
+	{
+		assert(_resident > 0);
+		_a.deallocate(p, block_size);
+		--_resident;
+	}
+
+	// -----
+	// write
+	// -----
+
+	/**
+	* Write an inner array to the spill file and free it
+	* @param p - the inner array
+	* @return the file offset of the inner array
+	* @throws system_error exception if the write fails
+	*/
+	size_type write (pointer p)
+	{
+		size_type offset = length;
+		if(free_slots.empty())
+			length += block_bytes;
+		else
+		{
+			offset = free_slots.back();
+			free_slots.pop_back();
+		}
+		if(pwrite(fd, p, block_bytes, offset) != static_cast<ssize_t>(block_bytes))
+		{
+			free_slots.push_back(offset);
+			fail("pwrite");
+		}
+		release(p);
+		++_stats.spills;
+		_stats.spill_bytes += block_bytes;
+		return offset;
+	}
+
+	// ----
+	// fill
+	// ----
+
+	/**
+	* Read an inner array back from the spill file, waiting for a prefetch if one is in flight
+	* @param offset - the file offset of the inner array
+	* @return the inner array
+	* @throws system_error exception if the read fails
+	*/
+	pointer fill (size_type offset)
+	{
+		pointer p;
+		bool done;
+		typename std::map<size_type, std::pair<pointer, std::future<bool> > >::iterator i = pending.find(offset);
+		if(i != pending.end())
+		{
+			p = i->second.first;
+			done = i->second.second.get();
+			pending.erase(i);
+		}
+		else
+		{
+			++_stats.stalls;
+			p = _a.allocate(block_size);
+			done = read(fd, p, block_bytes, offset);
+		}
+		if(!done)
+		{
+			_a.deallocate(p, block_size);
+			fail("pread");
+		}
+		free_slots.push_back(offset);
+		++_resident;
+		++_stats.fills;
+		_stats.fill_bytes += block_bytes;
+		return p;
+	}
+
+	// --------
+	// prefetch
+	// --------
+
+	/**
+	* Start reading an inner array back from the spill file on another thread
+	* @param offset - the file offset of the inner array
+	*/
+	void prefetch (size_type offset)
+	{
+		if(pending.count(offset))
+			return;
+		pointer p = _a.allocate(block_size);
+		pending[offset] = std::make_pair(p, std::async(std::launch::async, &SpillFile::read, fd, p, block_bytes, offset));
+		++_stats.prefetches;
+	}
+
+	// -------
+	// discard
+	// -------
+
+	/**
+	* Drop a spilled inner array without reading it
+	* @param offset - the file offset of the inner array
+	*/
+	void discard (size_type offset)
+	{
+		typename std::map<size_type, std::pair<pointer, std::future<bool> > >::iterator i = pending.find(offset);
+		if(i != pending.end())
+		{
+			i->second.second.wait();
+			_a.deallocate(i->second.first, block_size);
+			pending.erase(i);
+		}
+		free_slots.push_back(offset);
+	}
+
+	// ----------
+	// accounting
+	// ----------
+
+	/**
+	* @return true if more inner arrays are in memory than the memory budget allows
+	*/
+	bool over () const
+	{
+		return _resident > _budget;
+	}
+
+	/**
+	* Set the # of inner arrays in memory after the MyDeque container rebuilt its outer array
+	* @param n - the # of inner arrays in memory
+	*/
+	void resident (size_type n)
+	{
+		_resident = n;
+	}
+
+	/**
+	* @return the counters of the spill file
+	*/
+	const SpillStats& stats () const
+	{
+		return _stats;
+	}
+};
+
+#endif // Spill_h
@@ -0,0 +1,543 @@
+// -------------
+// StaticDeque.h
+// -------------
+
+#ifndef StaticDeque_h
+#define StaticDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>          // assert
+#include <cstddef>          // ptrdiff_t, size_t
+#include <initializer_list> // initializer_list
+#include <stdexcept>        // out_of_range
+
+#include "Iterator.h" // DEQUE_CONSTEXPR14, IndexIterator
+
+// -----------
+// StaticDeque
+// -----------
+
+///
+/// A deque of at most N elements stored in a ring inside the object, which never allocates
+/// Every slot holds a default constructed element; pop assigns a default constructed value to the slot it frees.
+/// For a literal type T, the constructors and const members are constexpr, and so are the mutators and comparisons from C++14 on.
+/// Push on a full StaticDeque is a precondition violation; try_push_back and try_push_front report it instead.
+/// @tparam T - Type of the elements, which must be default constructible
+/// @tparam N - the capacity
+///
+template <typename T, std::size_t N>
+class StaticDeque
+{
+	static_assert(N > 0, "StaticDeque requires a capacity of at least one");
+
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef T                 value_type;
+
+	typedef std::size_t       size_type;
+	typedef std::ptrdiff_t    difference_type;
+
+	typedef value_type*       pointer;
+	typedef const value_type* const_pointer;
+
+	typedef value_type&       reference;
+	typedef const value_type& const_reference;
+
+	typedef IndexIterator<StaticDeque, value_type, reference, pointer>                   iterator;
+	typedef IndexIterator<const StaticDeque, value_type, const_reference, const_pointer> const_iterator;
+
+public:
+	// -----------
+	// operator ==
+	// -----------
+
+	/**
+	* equal operator
+	* @param lhs - the left hand side StaticDeque
+	* @param rhs - the right hand side StaticDeque
+	* @return true if the lhs StaticDeque is equal to the rhs StaticDeque
+	*/
+	friend DEQUE_CONSTEXPR14 bool operator == (const StaticDeque& lhs, const StaticDeque& rhs)
+	{
+		// a loop instead of std::equal, which is constexpr only from C++20 on
+		if(lhs.size() != rhs.size())
+			return false;
+		for(size_type i = 0; i != lhs.size(); ++i)
+			if(!(lhs[i] == rhs[i]))
+				return false;
+		return true;
+	}
+
+	/**
+	* not equal operator
+	* @param lhs - the left hand side StaticDeque
+	* @param rhs - the right hand side StaticDeque
+	* @return true if the lhs StaticDeque is not equal to the rhs StaticDeque
+	*/
+	friend DEQUE_CONSTEXPR14 bool operator != (const StaticDeque& lhs, const StaticDeque& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// ----------
+	// operator <
+	// ----------
+
+	/**
+	* less than operator
+	* @param lhs - the left hand side StaticDeque
+	* @param rhs - the right hand side StaticDeque
+	* @return true if the lhs StaticDeque is lexicographically less than the rhs StaticDeque
+	*/
+	friend DEQUE_CONSTEXPR14 bool operator < (const StaticDeque& lhs, const StaticDeque& rhs)
+	{
+		// a loop instead of std::lexicographical_compare, which is constexpr only from C++20 on
+		for(size_type i = 0; i != lhs.size(); ++i)
+		{
+			if(i == rhs.size() || rhs[i] < lhs[i])
+				return false;
+			if(lhs[i] < rhs[i])
+				return true;
+		}
+		return lhs.size() < rhs.size();
+	}
+
+private:
+	// ----
+	// data
+	// ----
+
+	value_type _data[N];
+	size_type b;     // the slot of the first element
+	size_type count; // the # of elements
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the StaticDeque object is in a valid state
+	///
+	constexpr bool valid () const
+	{
+		return (b < N) && (count <= N);
+	}
+
+	///
+	/// @param index - element position in the container
+	/// @return the slot of the element
+	///
+	constexpr size_type slot (size_type index) const
+	{
+		return (b + index) % N;
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty StaticDeque container
+	*/
+	constexpr StaticDeque () : _data (), b (0), count (0)
+	{}
+
+	/**
+	* Create a StaticDeque container with s elements, each of them a copy of v
+	* @param s - the # of elements, at most N
+	* @param v - value to fill the container with
+	*/
+	DEQUE_CONSTEXPR14 StaticDeque (size_type s, const_reference v) : _data (), b (0), count (0)
+	{
+		assert(s <= N);
+		while(count != s)
+			_data[count++] = v;
+	}
+
+	/**
+	* Create a StaticDeque container with the elements of an initializer list
+	* @param x - an initializer list of at most N elements
+	*/
+	DEQUE_CONSTEXPR14 StaticDeque (std::initializer_list<value_type> x) : _data (), b (0), count (0)
+	{
+		assert(x.size() <= N);
+		for(const value_type* p = x.begin(); p != x.end(); ++p)
+			_data[count++] = *p;
+	}
+
+	// Default copy, destructor, and copy assignment
+	// StaticDeque  (const StaticDeque&);
+	// ~StaticDeque ();
+	// StaticDeque& operator = (const StaticDeque&);
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* subscript operator
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	*/
+	DEQUE_CONSTEXPR14 reference operator [] (size_type index)
+	{
+		return _data[slot(index)];
+	}
+
+	/**
+	* const subscript operator
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	*/
+	constexpr const_reference operator [] (size_type index) const
+	{
+		return _data[slot(index)];
+	}
+
+	// --
+	// at
+	// --
+
+	/**
+	* Returns a reference to the element at position index in the StaticDeque container object
+	* @param index - element position in the container
+	* @return a reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 reference at (size_type index)
+	{
+		if(index >= count)
+			throw std::out_of_range("deque::_M_range_check");
+		return (*this)[index];
+	}
+
+	/**
+	* Returns a const reference to the element at position index in the StaticDeque container object
+	* @param index - element position in the container
+	* @return a const reference to the element at the position in the container
+	* @throws out_of_range exception if position index is not within the bounds of the StaticDeque container
+	*/
+	constexpr const_reference at (size_type index) const
+	{
+		return (index < count) ? (*this)[index] : throw std::out_of_range("deque::_M_range_check");
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* Access last element
+	* @return a reference to the last element of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 reference back ()
+	{
+		assert(!empty());
+		return (*this)[count - 1];
+	}
+
+	/**
+	* Access last element
+	* @return a const reference to the last element of the StaticDeque container
+	*/
+	constexpr const_reference back () const
+	{
+		return (*this)[count - 1];
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return an Iterator to the beginning of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 iterator begin ()
+	{
+		return iterator(this, 0);
+	}
+
+	/**
+	* @return a Const Iterator to the beginning of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 const_iterator begin () const
+	{
+		return const_iterator(this, 0);
+	}
+
+	// --------
+	// capacity
+	// --------
+
+	/**
+	* @return the # of elements the StaticDeque container can hold
+	*/
+	constexpr size_type capacity () const
+	{
+		return N;
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove all elements of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 void clear ()
+	{
+		while(count != 0)
+			pop_back();
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* Test whether the StaticDeque container is empty
+	* @return true if the StaticDeque container contains zero elements
+	*/
+	constexpr bool empty () const
+	{
+		return count == 0;
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return an Iterator to the end of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 iterator end ()
+	{
+		return iterator(this, count);
+	}
+
+	/**
+	* @return a Const Iterator to the end of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 const_iterator end () const
+	{
+		return const_iterator(this, count);
+	}
+
+	// -----
+	// erase
+	// -----
+
+	/**
+	* Remove an element, shifting the elements on its shorter side
+	* @param i - an Iterator to the element
+	* @return an Iterator to the element after the removed one
+	*/
+	DEQUE_CONSTEXPR14 iterator erase (iterator i)
+	{
+		size_type index = i.index();
+		assert(index < count);
+		if(index < count / 2)
+		{
+			for(size_type j = index; j != 0; --j)
+				(*this)[j] = (*this)[j - 1];
+			pop_front();
+		}
+		else
+		{
+			for(size_type j = index; j + 1 != count; ++j)
+				(*this)[j] = (*this)[j + 1];
+			pop_back();
+		}
+		return iterator(this, index);
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* Access first element
+	* @return a reference to the first element of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 reference front ()
+	{
+		assert(!empty());
+		return _data[b];
+	}
+
+	/**
+	* Access first element
+	* @return a const reference to the first element of the StaticDeque container
+	*/
+	constexpr const_reference front () const
+	{
+		return _data[b];
+	}
+
+	// ----
+	// full
+	// ----
+
+	/**
+	* @return true if the StaticDeque container holds N elements
+	*/
+	constexpr bool full () const
+	{
+		return count == N;
+	}
+
+	// ------
+	// insert
+	// ------
+
+	/**
+	* Insert an element before an Iterator, shifting the elements on its shorter side
+	* @param i - an Iterator to the position of the new element
+	* @param v - a const reference to the value of the new element
+	* @return an Iterator to the new element
+	*/
+	DEQUE_CONSTEXPR14 iterator insert (iterator i, const_reference v)
+	{
+		size_type index = i.index();
+		assert(index <= count && !full());
+		// v may be an element of the container, which the shifts below overwrite
+		value_type x = v;
+		if(index < count / 2)
+		{
+			push_front(x);
+			for(size_type j = 0; j != index; ++j)
+				(*this)[j] = (*this)[j + 1];
+		}
+		else
+		{
+			push_back(x);
+			for(size_type j = count - 1; j != index; --j)
+				(*this)[j] = (*this)[j - 1];
+		}
+		(*this)[index] = x;
+		return iterator(this, index);
+	}
+
+	// ---
+	// pop
+	// ---
+
+	/**
+	* Delete the last element of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 void pop_back ()
+	{
+		assert(!empty());
+		--count;
+		_data[slot(count)] = value_type();
+		assert(valid());
+	}
+
+	/**
+	* Delete the first element of the StaticDeque container
+	*/
+	DEQUE_CONSTEXPR14 void pop_front ()
+	{
+		assert(!empty());
+		_data[b] = value_type();
+		b = (b + 1) % N;
+		--count;
+		assert(valid());
+	}
+
+	// ----
+	// push
+	// ----
+
+	/**
+	* Add element to the end of the StaticDeque container, which must not be full
+	* @param v - a const reference to the value of the new element
+	*/
+	DEQUE_CONSTEXPR14 void push_back (const_reference v)
+	{
+		assert(!full());
+		_data[slot(count)] = v;
+		++count;
+		assert(valid());
+	}
+
+	/**
+	* Add element to the front of the StaticDeque container, which must not be full
+	* @param v - a const reference to the value of the new element
+	*/
+	DEQUE_CONSTEXPR14 void push_front (const_reference v)
+	{
+		assert(!full());
+		b = (b + N - 1) % N;
+		_data[b] = v;
+		++count;
+		assert(valid());
+	}
+
+	// --------
+	// try_push
+	// --------
+
+	/**
+	* Add element to the end of the StaticDeque container unless it is full
+	* @param v - a const reference to the value of the new element
+	* @return true if the element was added
+	*/
+	DEQUE_CONSTEXPR14 bool try_push_back (const_reference v)
+	{
+		if(full())
+			return false;
+		push_back(v);
+		return true;
+	}
+
+	/**
+	* Add element to the front of the StaticDeque container unless it is full
+	* @param v - a const reference to the value of the new element
+	* @return true if the element was added
+	*/
+	DEQUE_CONSTEXPR14 bool try_push_front (const_reference v)
+	{
+		if(full())
+			return false;
+		push_front(v);
+		return true;
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the number of elements in the StaticDeque container
+	*/
+	constexpr size_type size () const
+	{
+		return count;
+	}
+
+	// ----
+	// swap
+	// ----
+
+	/**
+	* Exchange the contents of two StaticDeque containers element by element
+	* @param that - a StaticDeque container of the same type
+	*/
+	DEQUE_CONSTEXPR14 void swap (StaticDeque& that)
+	{
+		StaticDeque x = *this;
+		*this = that;
+		that = x;
+	}
+};
+
+#endif // StaticDeque_h
@@ -10,6 +10,13 @@
 #define SIZE 500
 #define ITERATION 1000
 
+// count the instrumentation events and record the latencies of MyDeque, unless TestDequeBare is built with -DDEQUE_BARE
+// to test the layout without them
+#ifndef DEQUE_BARE
+#define DEQUE_STATS
+#define DEQUE_LATENCY
+#endif
+
 /*
    To test the program:
    % ls -al /usr/include/gtest/
@@ -39,6 +46,8 @@
 #include <algorithm> // equal
 #include <cstring>   // strcmp
 #include <deque>     // deque
+#include <limits>    // numeric_limits
+#include <map>       // map
 #include <sstream>   // ostringstream
 #include <stdexcept> // invalid_argument
 #include <string>    // ==
@@ -50,7 +59,19 @@
 
 #include "gtest/gtest.h"
 
+#include "AlignedAllocator.h"
+#include "Channel.h"
+#include "CowDeque.h"
 #include "Deque.h"
+#include "LogDeque.h"
+#include "MappedDeque.h"
+#include "NumaAllocator.h"
+#include "PackedDeque.h"
+#include "RopeDeque.h"
+#include "Simd.h"
+#include "SoaDeque.h"
+#include "StaticDeque.h"
+#include "WindowDeque.h"
 
 // ---------------
 // DEQUE_FUNCTIONS
@@ -2030,6 +2051,55 @@ TEST(DequePrivate, rebuild_greater_sizet)
 	ASSERT_TRUE(new_capacity > 2 * capacity);
 }
 
+TEST(DequePrivate, circular_drift)
+{
+	MyDeque<int> x;
+	std::deque<int> y;
+	for(int i = 0; i < 1500; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+	}
+	int** cb = x.cb;
+	int** ce = x.ce;
+	for(int i = 1500; i < 20000; ++i)
+	{
+		x.push_back(i);
+		x.pop_front();
+		y.push_back(i);
+		y.pop_front();
+	}
+	ASSERT_TRUE(x.cb == cb);
+	ASSERT_TRUE(x.ce == ce);
+	ASSERT_TRUE(x.valid());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	for(size_t i = 0; i < y.size(); ++i)
+		ASSERT_EQ(x[i], y[i]);
+}
+
+TEST(DequePrivate, circular_push_front_wrap)
+{
+	MyDeque<int> x;
+	for(int i = 0; i < 2500; ++i)
+		x.push_back(i);
+	for(int i = 0; i < 2000; ++i)
+		x.pop_front();
+	int** cb = x.cb;
+	ASSERT_TRUE(x.pb == x.cb);
+	ASSERT_EQ(x.b, 0);
+	x.push_front(-2);
+	ASSERT_TRUE(x.cb == cb);
+	ASSERT_TRUE(x.pb == x.ce - 1);
+	ASSERT_TRUE(x.valid());
+	ASSERT_EQ(x.front(), -2);
+	ASSERT_EQ(x[1], 2000);
+	ASSERT_EQ(x.back(), 2499);
+	x.insert(x.begin() + 1, -3);
+	ASSERT_EQ(x[1], -3);
+	ASSERT_EQ(x[2], 2000);
+	ASSERT_EQ(x.size(), 502);
+}
+
 TEST(DequePrivate, ia_copy)
 {
 	MyDeque<int> x;
@@ -2104,3 +2174,2117 @@ TEST(DequePrivate, ia_copy_swap_large)
     ASSERT_TRUE(std::count(y.begin() + SIZET, y.end(), 25) >= (ptrdiff_t) SIZET);
     ASSERT_EQ(std::count(x.begin(), x.end(), 25), x.size());
 }
+
+TEST(DequeFixedTest, no_allocation)
+{
+	MyDeque<int> x(2500, MyDeque<int>::reject);
+	int** cb = x.cb;
+	int* first = *x.cb;
+	std::deque<int> y;
+	for(int i = 0; i < 20000; ++i)
+	{
+		if(i % 3)
+		{
+			x.push_back(i);
+			y.push_back(i);
+		}
+		else
+		{
+			x.push_front(i);
+			y.push_front(i);
+		}
+		if(y.size() == 2500)
+		{
+			x.pop_front();
+			y.pop_front();
+			x.pop_back();
+			y.pop_back();
+		}
+	}
+	ASSERT_TRUE(x.cb == cb);
+	ASSERT_TRUE(*x.cb == first);
+	ASSERT_TRUE(x.valid());
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+}
+
+TEST(DequeFixedTest, reject)
+{
+	MyDeque<int> x(3, MyDeque<int>::reject);
+	ASSERT_TRUE(x.empty());
+	ASSERT_TRUE(x.try_push_back(1));
+	ASSERT_TRUE(x.try_push_back(2));
+	ASSERT_TRUE(x.try_push_front(0));
+	ASSERT_TRUE(x.full());
+	ASSERT_FALSE(x.try_push_back(3));
+	ASSERT_FALSE(x.try_push_front(3));
+	ASSERT_THROW(x.push_back(3), std::length_error);
+	ASSERT_THROW(x.insert(x.begin(), 3), std::length_error);
+	ASSERT_THROW(x.resize(4), std::length_error);
+	ASSERT_EQ(x.size(), 3);
+	ASSERT_EQ(x[0], 0);
+	ASSERT_EQ(x[2], 2);
+}
+
+TEST(DequeFixedTest, overwrite)
+{
+	MyDeque<int> x(3, MyDeque<int>::overwrite);
+	for(int i = 0; i < 5; ++i)
+		x.push_back(i);
+	ASSERT_EQ(x.size(), 3);
+	ASSERT_EQ(x.front(), 2);
+	ASSERT_EQ(x.back(), 4);
+	x.push_front(x.back());
+	ASSERT_EQ(x.size(), 3);
+	ASSERT_EQ(x.front(), 4);
+	ASSERT_EQ(x.back(), 3);
+	MyDeque<int> y(x);
+	ASSERT_TRUE(y.full());
+	y.push_back(5);
+	ASSERT_EQ(y.front(), 2);
+	ASSERT_EQ(x.front(), 4);
+}
+
+TEST(MappedDequeTest, push_pop)
+{
+	const char* path = "TestDeque.map";
+	unlink(path);
+	{
+		MappedDeque<int> x(path);
+		std::deque<int> y;
+		ASSERT_TRUE(x.empty());
+		for(int i = 0; i < 5000; ++i)
+		{
+			x.push_back(i);
+			x.push_front(-i);
+			y.push_back(i);
+			y.push_front(-i);
+		}
+		for(int i = 0; i < 2500; ++i)
+		{
+			x.pop_front();
+			x.pop_back();
+			y.pop_front();
+			y.pop_back();
+		}
+		ASSERT_EQ(x.size(), y.size());
+		ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+		ASSERT_EQ(x.at(0), y.at(0));
+		ASSERT_THROW(x.at(x.size()), std::out_of_range);
+		// every old outer array was reused as inner arrays, so the file holds the header, the outer array and the inner arrays
+		const size_t page = sysconf(_SC_PAGESIZE);
+		const size_t block = (SIZET * sizeof(int) + page - 1) / page * page;
+		ASSERT_EQ(x.h()->length, page + (x.h()->outer * 8 + page - 1) / page * page + x.h()->outer * block);
+	}
+	unlink(path);
+}
+
+TEST(MappedDequeTest, reopen)
+{
+	const char* path = "TestDeque.map";
+	unlink(path);
+	{
+		MappedDeque<double> x(path);
+		for(int i = 0; i < 3000; ++i)
+			x.push_back(i * 0.5);
+		for(int i = 0; i < 1500; ++i)
+			x.pop_front();
+		x.push_front(-1.0);
+		x.sync();
+	}
+	{
+		MappedDeque<double> x(path);
+		ASSERT_EQ(x.size(), 1501);
+		ASSERT_EQ(x.front(), -1.0);
+		ASSERT_EQ(x[1], 750.0);
+		ASSERT_EQ(x.back(), 1499.5);
+		x.push_back(1500.0);
+	}
+	{
+		MappedDeque<double> x(path);
+		ASSERT_EQ(x.size(), 1502);
+		ASSERT_EQ(x.back(), 1500.0);
+	}
+	ASSERT_THROW(MappedDeque<int> x(path), std::runtime_error);
+	unlink(path);
+}
+
+TEST(DequeSpillTest, fifo)
+{
+	MyDeque<int> x;
+	x.set_memory_budget(8 * SIZET * sizeof(int), "TestDeque.spill");
+	std::deque<int> y;
+	for(int i = 0; i < 50 * SIZET; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+	}
+	ASSERT_TRUE(x.spill_stats().spills >= 40);
+	ASSERT_EQ(x.spill_stats().fills, 0);
+	for(int i = 0; i < 40 * SIZET; ++i)
+	{
+		ASSERT_EQ(x.front(), y.front());
+		x.pop_front();
+		y.pop_front();
+	}
+	ASSERT_TRUE(x.spill_stats().fills >= 30);
+	ASSERT_TRUE(x.spill_stats().prefetches > 0);
+	ASSERT_EQ(x.spill_stats().fill_bytes, x.spill_stats().fills * SIZET * sizeof(int));
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_TRUE(x.valid());
+}
+
+TEST(DequeSpillTest, both_ends)
+{
+	MyDeque<int> x;
+	for(int i = 0; i < 5 * SIZET; ++i)
+		x.push_back(i);
+	x.set_memory_budget(0, "TestDeque.spill");
+	std::deque<int> y(x.begin(), x.end());
+	for(int i = 0; i < 20 * SIZET; ++i)
+	{
+		x.push_front(-i);
+		y.push_front(-i);
+		x.push_back(i);
+		y.push_back(i);
+	}
+	ASSERT_TRUE(x.spill_stats().spills > 0);
+	for(int i = 0; i < 15 * SIZET; ++i)
+	{
+		ASSERT_EQ(x.back(), y.back());
+		x.pop_back();
+		y.pop_back();
+	}
+	x.insert(x.begin() + 7 * SIZET, 42);
+	y.insert(y.begin() + 7 * SIZET, 42);
+	ASSERT_EQ(x.size(), y.size());
+	for(size_t i = 0; i < y.size(); ++i)
+		ASSERT_EQ(x[i], y[i]);
+	MyDeque<int> z(x);
+	ASSERT_TRUE(z == x);
+	x.clear();
+	ASSERT_TRUE(x.empty());
+}
+
+TEST(DequeSpillTest, references)
+{
+	MyDeque<int> x;
+	x.set_memory_budget(8 * SIZET * sizeof(int), "TestDeque.spill");
+	std::deque<int> y;
+	for(int i = 0; i < 30 * SIZET; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+	}
+	// each pair of blocks far apart is loaded back one after the other, and the first must not be spilled under the reference
+	for(int i = 0; i < 10; ++i)
+	{
+		std::swap(x[i * SIZET + 3], x[(29 - i) * SIZET - 7]);
+		std::swap(y[i * SIZET + 3], y[(29 - i) * SIZET - 7]);
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	std::reverse(x.begin(), x.end());
+	std::reverse(y.begin(), y.end());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_TRUE(x.spill_stats().spills > 0);
+}
+
+TEST(DequeSerializeTest, stream)
+{
+	MyDeque<int> x;
+	for(int i = 0; i < 3 * SIZET; ++i)
+		x.push_back(i);
+	for(int i = 0; i < SIZET + 10; ++i)
+		x.pop_front();
+	x.push_front(-1);
+	std::stringstream out;
+	x.serialize(out);
+	ASSERT_EQ(out.str().size(), 4 * sizeof(uint64_t) + x.size() * sizeof(int));
+	MyDeque<int> y(5, 5);
+	y.deserialize(out);
+	ASSERT_TRUE(x == y);
+	ASSERT_EQ(y.b, x.b);
+	ASSERT_TRUE(y.valid());
+}
+
+TEST(DequeSerializeTest, stream_wrong_type)
+{
+	MyDeque<int> x(10, 1);
+	std::stringstream out;
+	x.serialize(out);
+	MyDeque<double> y;
+	ASSERT_THROW(y.deserialize(out), std::runtime_error);
+}
+
+TEST(DequeSerializeTest, stream_wrong_block_length)
+{
+	MyDeque<int> x(10, 1);
+	std::stringstream out;
+	x.serialize(out);
+	std::string s = out.str();
+	uint64_t n = 512;
+	s.replace(sizeof(uint64_t), sizeof(n), reinterpret_cast<const char*>(&n), sizeof(n));
+	std::stringstream in(s);
+	MyDeque<int> y;
+	ASSERT_THROW(y.deserialize(in), std::runtime_error);
+	FILE* f = tmpfile();
+	fwrite(s.data(), 1, s.size(), f);
+	rewind(f);
+	ASSERT_THROW(y.deserialize(fileno(f)), std::runtime_error);
+	fclose(f);
+	ASSERT_TRUE(y.empty());
+}
+
+TEST(DequeSerializeTest, fd)
+{
+	MyDeque<double> x;
+	for(int i = 0; i < 5 * SIZET + 7; ++i)
+		x.push_front(i * 0.5);
+	FILE* f = tmpfile();
+	x.serialize(fileno(f));
+	rewind(f);
+	MyDeque<double> y;
+	y.deserialize(fileno(f));
+	ASSERT_TRUE(x == y);
+	rewind(f);
+	MyDeque<double> z(x.size(), MyDeque<double>::reject);
+	z.deserialize(fileno(f));
+	ASSERT_TRUE(x == z);
+	rewind(f);
+	MyDeque<double> w(10, MyDeque<double>::reject);
+	ASSERT_THROW(w.deserialize(fileno(f)), std::length_error);
+	fclose(f);
+}
+
+TEST(DequeAlignedTest, cache_line)
+{
+	MyDeque<int, Aligned_Allocator<int, 64> > x;
+	for(int i = 0; i < 5 * SIZET; ++i)
+		x.push_front(i);
+	ASSERT_EQ(reinterpret_cast<uintptr_t>(x.cb) % 64, 0);
+	for(int** p = x.cb; p != x.ce; ++p)
+		ASSERT_EQ(reinterpret_cast<uintptr_t>(*p) % 64, 0);
+	ASSERT_EQ(x.back(), 0);
+	ASSERT_EQ(x.front(), 5 * SIZET - 1);
+}
+
+TEST(DequeAlignedTest, huge_pages)
+{
+	typedef MyDeque<int, Aligned_Allocator<int, 128, transparent_huge_pages> > D;
+	D x;
+	std::deque<int> y;
+	for(int i = 0; i < 10 * SIZET; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+	}
+	for(int** p = x.cb; p != x.ce; ++p)
+		ASSERT_EQ(reinterpret_cast<uintptr_t>(*p) % 128, 0);
+	D z(x);
+	x.clear();
+	ASSERT_TRUE(std::equal(z.begin(), z.end(), y.begin()));
+	MyDeque<int, Aligned_Allocator<int, 64, explicit_huge_pages> > w(3 * SIZET, 7);
+	ASSERT_EQ(std::count(w.begin(), w.end(), 7), 3 * SIZET);
+}
+
+TEST(DequeNumaTest, policies)
+{
+	Numa_Policy p[] = {first_touch, local, interleaved, pinned};
+	// pin to the highest node the process may use, which on a machine with several nodes is not where blocks land by default
+	unsigned long allowed = numa::allowed();
+	int last = -1;
+	for(int j = 0; j < static_cast<int>(numa::max_node); ++j)
+		if(allowed & (1UL << j))
+			last = j;
+	for(int i = 0; i < 4; ++i)
+	{
+		MyDeque<int, Numa_Allocator<int> > x((Numa_Allocator<int>(p[i], last)));
+		std::deque<int> y;
+		for(int j = 0; j < 3 * SIZET + 10; ++j)
+		{
+			x.push_front(j);
+			y.push_front(j);
+		}
+		ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+		std::vector<int> nodes = x.block_nodes();
+		ASSERT_EQ(nodes.size(), (x.b + x.size() + SIZET - 1) / SIZET);
+		for(size_t j = 0; j < nodes.size(); ++j)
+		{
+			if(last == -1)
+				ASSERT_EQ(nodes[j], -1);
+			else if(p[i] == pinned)
+				ASSERT_EQ(nodes[j], last);
+			else
+			{
+				ASSERT_GE(nodes[j], 0);
+				ASSERT_TRUE(allowed & (1UL << nodes[j]));
+			}
+		}
+	}
+}
+
+TEST(DequeNumaTest, pinned_missing_node)
+{
+	MyDeque<int, Numa_Allocator<int> > x(5 * SIZET, 3, Numa_Allocator<int>(pinned, 63));
+	ASSERT_EQ(std::count(x.begin(), x.end(), 3), 5 * SIZET);
+	MyDeque<int, Numa_Allocator<int> > y(x);
+	ASSERT_TRUE(x == y);
+	ASSERT_EQ(x.block_nodes().size(), 5);
+}
+
+///
+/// Sum the elements of each segment and remember the segment lengths
+///
+struct SegmentSum
+{
+	long long sum;
+	std::vector<ptrdiff_t> lengths;
+
+	SegmentSum () : sum (0)
+	{}
+
+	void operator () (const int* b, const int* e)
+	{
+		lengths.push_back(e - b);
+		while(b != e)
+			sum += *b++;
+	}
+};
+
+TEST(DequeSegmentTest, for_each_segment)
+{
+	MyDeque<int> x;
+	for(int i = 0; i < 3 * SIZET; ++i)
+		x.push_back(i);
+	for(int i = 0; i < 10; ++i)
+		x.pop_front();
+	const MyDeque<int>& y = x;
+	SegmentSum f = y.for_each_segment(0, y.size(), SegmentSum());
+	ASSERT_EQ(f.sum, std::accumulate(x.begin(), x.end(), 0LL));
+	ASSERT_EQ(f.lengths.size(), 3);
+	ASSERT_EQ(f.lengths[0], SIZET - 10);
+	ASSERT_EQ(f.lengths[2], SIZET);
+	f = x.for_each_segment(5, 5 + SIZET, SegmentSum());
+	ASSERT_EQ(f.lengths.size(), 2);
+	ASSERT_EQ(f.sum, std::accumulate(x.begin() + 5, x.begin() + 5 + SIZET, 0LL));
+	f = x.for_each_segment(7, 7, SegmentSum());
+	ASSERT_TRUE(f.lengths.empty());
+}
+
+TEST(DequeSegmentTest, backward_iteration)
+{
+	MyDeque<int> x;
+	std::deque<int> y;
+	for(int i = 0; i < 5 * SIZET + 3; ++i)
+	{
+		x.push_front(i);
+		y.push_front(i);
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	MyDeque<int>::iterator i = x.end();
+	std::deque<int>::iterator j = y.end();
+	while(i != x.begin())
+		ASSERT_EQ(*--i, *--j);
+	const MyDeque<int>& z = x;
+	MyDeque<int>::const_iterator k = z.end();
+	j = y.end();
+	while(k != z.begin())
+		ASSERT_EQ(*--k, *--j);
+	MyDeque<int>::iterator l;
+	++l;
+	--l;
+	ASSERT_TRUE(l == MyDeque<int>::iterator());
+}
+
+// ----
+// simd
+// ----
+
+TEST(DequeSimdTest, int_kernels)
+{
+	simd::isa best = simd::active();
+	MyDeque<int> z;
+	const MyDeque<int>& x = z;
+	std::deque<int> y;
+	for(int i = 0; i < 3 * SIZET + 17; ++i)
+	{
+		int v = (i * 7919) % 1013 - 500;
+		z.push_front(v);
+		y.push_front(v);
+	}
+	z.push_back(-9999);
+	y.push_back(-9999);
+	for(int k = simd::scalar; k <= best; ++k)
+	{
+		simd::active() = static_cast<simd::isa>(k);
+		ASSERT_EQ(simd::count(x, 17), std::count(y.begin(), y.end(), 17));
+		ASSERT_EQ(std::distance(x.begin(), simd::find(x, 17)), std::distance(y.begin(), std::find(y.begin(), y.end(), 17)));
+		ASSERT_TRUE(simd::find(x, 100000) == x.end());
+		ASSERT_TRUE(simd::contains(x, -9999));
+		ASSERT_FALSE(simd::contains(x, 100000));
+		ASSERT_EQ(std::distance(x.begin(), simd::min_element(x)), std::distance(y.begin(), std::min_element(y.begin(), y.end())));
+		ASSERT_EQ(std::distance(x.begin(), simd::max_element(x)), std::distance(y.begin(), std::max_element(y.begin(), y.end())));
+		ASSERT_EQ(simd::accumulate(x, 3), std::accumulate(y.begin(), y.end(), 3));
+	}
+	simd::active() = best;
+}
+
+TEST(DequeSimdTest, float_kernels)
+{
+	simd::isa best = simd::active();
+	MyDeque<float> z;
+	const MyDeque<float>& x = z;
+	std::deque<float> y;
+	for(int i = 0; i < 2 * SIZET + 5; ++i)
+	{
+		float v = static_cast<float>((i * 31) % 97) / 4;
+		z.push_back(v);
+		y.push_back(v);
+	}
+	for(int k = simd::scalar; k <= best; ++k)
+	{
+		simd::active() = static_cast<simd::isa>(k);
+		ASSERT_EQ(simd::count(x, 2.25f), std::count(y.begin(), y.end(), 2.25f));
+		ASSERT_EQ(std::distance(x.begin(), simd::find(x, 2.25f)), std::distance(y.begin(), std::find(y.begin(), y.end(), 2.25f)));
+		ASSERT_EQ(std::distance(x.begin(), simd::min_element(x)), std::distance(y.begin(), std::min_element(y.begin(), y.end())));
+		ASSERT_EQ(std::distance(x.begin(), simd::max_element(x)), std::distance(y.begin(), std::max_element(y.begin(), y.end())));
+		ASSERT_EQ(simd::accumulate(x, 0.0f), std::accumulate(y.begin(), y.end(), 0.0f));
+	}
+	simd::active() = best;
+}
+
+TEST(DequeSimdTest, other_types)
+{
+	MyDeque<std::string> x;
+	ASSERT_TRUE(simd::min_element(x) == x.end());
+	ASSERT_EQ(simd::accumulate(x, std::string("a")), "a");
+	x.push_back("c");
+	x.push_back("b");
+	x.push_front("d");
+	x.push_back("b");
+	ASSERT_EQ(simd::count(x, std::string("b")), 2);
+	ASSERT_TRUE(simd::find(x, std::string("b")) == x.begin() + 2);
+	ASSERT_EQ(*simd::min_element(x), "b");
+	ASSERT_EQ(*simd::max_element(x), "d");
+	ASSERT_EQ(simd::accumulate(x, std::string()), "dcbb");
+}
+
+TEST(DequeSimdTest, spilled)
+{
+	MyDeque<int> x;
+	x.set_memory_budget(8 * SIZET * sizeof(int), "TestDeque.spill");
+	for(int i = 0; i < 20 * SIZET; ++i)
+		x.push_back(i % (3 * SIZET));
+	x[15 * SIZET + 7] = -1;
+	x[4 * SIZET + 3] = 5 * SIZET;
+	std::size_t fills = x.spill_stats().fills;
+	const MyDeque<int>& y = x;
+	ASSERT_TRUE(simd::find(y, 5) == y.begin() + 5);
+	ASSERT_LE(x.spill_stats().fills, fills + 1);
+	ASSERT_TRUE(simd::min_element(y) == y.begin() + 15 * SIZET + 7);
+	ASSERT_TRUE(simd::max_element(y) == y.begin() + 4 * SIZET + 3);
+	ASSERT_TRUE(simd::find(y, static_cast<int>(3 * SIZET)) == y.end());
+}
+
+// ---------
+// RopeDeque
+// ---------
+
+TEST(RopeDequeTest, push_pop)
+{
+	RopeDeque<int> x;
+	std::deque<int> y;
+	for(int i = 0; i < 3 * SIZET + 7; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+		x.push_front(-i);
+		y.push_front(-i);
+	}
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_EQ(x.front(), y.front());
+	ASSERT_EQ(x.back(), y.back());
+	while(!y.empty())
+	{
+		ASSERT_EQ(x.back(), y.back());
+		x.pop_back();
+		y.pop_back();
+		if(y.empty())
+			break;
+		ASSERT_EQ(x.front(), y.front());
+		x.pop_front();
+		y.pop_front();
+	}
+	ASSERT_TRUE(x.empty());
+	ASSERT_EQ(x.last - x.first, 0);
+	x.push_front(5);
+	ASSERT_EQ(x.at(0), 5);
+	ASSERT_THROW(x.at(1), std::out_of_range);
+}
+
+TEST(RopeDequeTest, insert_erase_middle)
+{
+	RopeDeque<int> x;
+	std::deque<int> y;
+	unsigned k = 12345;
+	for(int i = 0; i < 6 * SIZET; ++i)
+	{
+		k = k * 1103515245 + 12345;
+		size_t j = (k >> 8) % (y.size() + 1);
+		ASSERT_EQ(*x.insert(x.begin() + j, i), i);
+		y.insert(y.begin() + j, i);
+	}
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_GT(x.last - x.first, 6);
+	for(int i = 0; i < 6 * SIZET - 10; ++i)
+	{
+		k = k * 1103515245 + 12345;
+		size_t j = (k >> 8) % y.size();
+		RopeDeque<int>::iterator p = x.erase(x.begin() + j);
+		y.erase(y.begin() + j);
+		if(j < y.size())
+		{
+			ASSERT_EQ(*p, y[j]);
+		}
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_LE(x.last - x.first, 2);
+}
+
+TEST(RopeDequeTest, insert_self)
+{
+	RopeDeque<std::string> x(SIZET, "a");
+	x[SIZET / 2] = "b";
+	x.insert(x.begin() + SIZET / 2, x[SIZET / 2]);
+	x.insert(x.begin() + 1, x[0]);
+	ASSERT_EQ(x.size(), SIZET + 2);
+	ASSERT_EQ(x[SIZET / 2 + 1], "b");
+	ASSERT_EQ(x[SIZET / 2 + 2], "b");
+	ASSERT_EQ(x[1], "a");
+}
+
+TEST(RopeDequeTest, copy_compare_segments)
+{
+	RopeDeque<int> x;
+	for(int i = 0; i < 2 * SIZET; ++i)
+		x.insert(x.begin() + x.size() / 2, i);
+	RopeDeque<int> y(x);
+	ASSERT_TRUE(x == y);
+	y.back() += 1;
+	ASSERT_TRUE(x < y);
+	y = x;
+	ASSERT_TRUE(x == y);
+	long long sum = 0;
+	size_t segments = 0;
+	const RopeDeque<int>& z = x;
+	z.for_each_segment(1, z.size() - 1, [&] (const int* b, const int* e)
+	{
+		++segments;
+		while(b != e)
+			sum += *b++;
+	});
+	ASSERT_EQ(sum, std::accumulate(x.begin(), x.end(), 0LL) - x.front() - x.back());
+	segments = 0;
+	z.for_each_segment(0, z.size(), [&] (const int*, const int*) {++segments;});
+	ASSERT_EQ(segments, x.last - x.first);
+	x.clear();
+	ASSERT_TRUE(x.empty());
+	x.swap(y);
+	ASSERT_EQ(x.size(), 2 * SIZET);
+	ASSERT_TRUE(y.empty());
+}
+
+// -----
+// stats
+// -----
+
+#ifdef DEQUE_STATS
+
+TEST(DequeStatsTest, counters)
+{
+	MyDeque<int> x;
+	for(int i = 0; i < 4 * SIZET; ++i)
+		x.push_back(i);
+	DequeStats s = x.stats();
+	ASSERT_GT(s.rebuilds, 0);
+	ASSERT_GT(s.rebuilt_elements, 0);
+	ASSERT_GE(s.block_allocations, 4);
+	ASSERT_EQ(s.shifted_elements, 0);
+	x.insert(x.begin() + 10, -1);
+	ASSERT_EQ(x.stats().shifted_elements, 4 * SIZET - 10);
+	x.erase(x.begin() + 10);
+	ASSERT_EQ(x.stats().shifted_elements, 2 * (4 * SIZET - 10));
+	size_t n = x.stats().subscripts;
+	x[5] = 7;
+	ASSERT_EQ(x.stats().subscripts, n + 1);
+	MyDeque<int> y;
+	y.swap(x);
+	ASSERT_EQ(x.stats().subscripts, n + 1);
+	ASSERT_EQ(y.stats().subscripts, 0);
+}
+
+struct StatsScrape
+{
+	std::string name;
+	DequeStats stats;
+
+	void operator () (const std::string& n, const DequeStats& s)
+	{
+		if(n.find("MyDeque<double") != std::string::npos)
+		{
+			name = n;
+			stats = s;
+		}
+	}
+};
+
+TEST(DequeStatsTest, registry)
+{
+	DequeStatsRegistry::instance().reset();
+	{
+		MyDeque<double> x(2 * SIZET, 1.0);
+		x.push_front(0.0);
+		MyDeque<double> y(x);
+	}
+	StatsScrape f = DequeStatsRegistry::instance().scrape(StatsScrape());
+	ASSERT_FALSE(f.name.empty());
+	ASSERT_GT(f.stats.block_allocations, 0);
+	ASSERT_EQ(f.stats.block_allocations, f.stats.block_frees);
+	ASSERT_GT(f.stats.rebuilds, 0);
+	DequeStatsRegistry::instance().reset();
+	f = DequeStatsRegistry::instance().scrape(StatsScrape());
+	ASSERT_EQ(f.stats.block_allocations, 0);
+}
+
+#else
+
+TEST(DequeStatsTest, counters)
+{
+	MyDeque<int> x(4 * SIZET, 1);
+	x.insert(x.begin() + 10, -1);
+	ASSERT_EQ(x.stats().rebuilds, 0);
+	ASSERT_EQ(x.stats().shifted_elements, 0);
+}
+
+#endif // DEQUE_STATS
+
+// -------
+// latency
+// -------
+
+TEST(DequeLatencyTest, histogram)
+{
+	LatencyHistogram h;
+	ASSERT_EQ(h.percentile(50), 0);
+	for(uint64_t v = 0; v < 16; ++v)
+		ASSERT_EQ(LatencyHistogram::highest(LatencyHistogram::bucket(v)), v);
+	for(uint64_t v = 16; v < 100000; v = v * 3 + 1)
+	{
+		size_t i = LatencyHistogram::bucket(v);
+		ASSERT_LE(v, LatencyHistogram::highest(i));
+		ASSERT_GT(v, LatencyHistogram::highest(i - 1));
+	}
+	ASSERT_TRUE(LatencyHistogram::bucket(~0ULL) < LatencyHistogram::buckets);
+	for(int i = 1; i <= 1000; ++i)
+		h.record(i);
+	h.record(5000000);
+	ASSERT_EQ(h.count(), 1001);
+	ASSERT_EQ(h.max(), 5000000);
+	ASSERT_GE(h.percentile(50), 500);
+	ASSERT_LE(h.percentile(50), 500 + 500 / 16);
+	ASSERT_GE(h.percentile(99), 990);
+	ASSERT_LE(h.percentile(99), 990 + 990 / 16);
+	ASSERT_EQ(h.percentile(100), 5000000);
+	h.reset();
+	ASSERT_EQ(h.count(), 0);
+}
+
+#ifdef DEQUE_LATENCY
+
+struct LatencyScrape
+{
+	std::map<std::string, size_t> counts;
+
+	void operator () (const std::string& type, const char* op, const LatencyHistogram& h)
+	{
+		if(type.find("MyDeque<long") != std::string::npos)
+			counts[op] = h.count();
+	}
+};
+
+TEST(DequeLatencyTest, registry)
+{
+	DequeLatencyRegistry& r = DequeLatencyRegistry::instance();
+	r.reset();
+	MyDeque<long> x;
+	for(long i = 0; i < 100; ++i)
+		x.push_back(i);
+	x.push_front(-1);
+	x.insert(x.begin() + 5, 7);
+	x.erase(x.begin() + 5);
+	x.pop_back();
+	x.pop_front();
+	MyDeque<long> y;
+	y = x;
+	LatencyScrape f = r.scrape(LatencyScrape());
+	ASSERT_EQ(f.counts["push_back"], 100);
+	ASSERT_EQ(f.counts["push_front"], 1);
+	ASSERT_EQ(f.counts["insert"], 1);
+	ASSERT_EQ(f.counts["erase"], 1);
+	ASSERT_EQ(f.counts["pop_back"], 1);
+	ASSERT_EQ(f.counts["pop_front"], 1);
+	ASSERT_EQ(f.counts["operator="], 1);
+	// push_back and pop_back call resize, which is recorded only when it is called directly
+	ASSERT_EQ(f.counts["resize"], 0);
+	r.sample_every(10);
+	for(long i = 0; i < 100; ++i)
+		x.push_back(i);
+	r.sample_every(1);
+	f = r.scrape(LatencyScrape());
+	ASSERT_EQ(f.counts["push_back"], 110);
+	std::ostringstream w;
+	r.dump(w);
+	ASSERT_NE(w.str().find("push_back\tcount 110\tp50 "), std::string::npos);
+	ASSERT_NE(w.str().find("p99.9"), std::string::npos);
+}
+
+#endif // DEQUE_LATENCY
+
+// -----------
+// StaticDeque
+// -----------
+
+constexpr StaticDeque<int, 4> static_empty;
+static_assert(static_empty.empty() && static_empty.size() == 0 && static_empty.capacity() == 4, "StaticDeque is constexpr");
+
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+constexpr int static_deque_build ()
+{
+	StaticDeque<int, 5> x = {1, 2, 3};
+	x.push_front(0);
+	x.pop_back();
+	x.push_back(9);
+	x.insert(x.begin() + 1, 7);
+	x.erase(x.begin() + 3);
+	int n = 0;
+	for(StaticDeque<int, 5>::iterator i = x.begin(); i != x.end(); ++i)
+		n = 10 * n + *i;
+	return n;
+}
+static_assert(static_deque_build() == 719, "StaticDeque mutators are constexpr");
+
+constexpr StaticDeque<int, 4> static_abc = {1, 2, 3};
+constexpr StaticDeque<int, 4> static_abd = {1, 2, 4};
+constexpr StaticDeque<int, 4> static_ab = {1, 2};
+static_assert(static_abc == static_abc && static_abc != static_abd && static_abc < static_abd && static_ab < static_abc &&
+	!(static_abc < static_ab) && !(static_abc < static_abc), "StaticDeque comparisons are constexpr");
+#endif
+
+TEST(StaticDequeTest, push_pop)
+{
+	StaticDeque<int, 8> x;
+	std::deque<int> y;
+	for(int i = 0; i < 20; ++i)
+	{
+		if(x.full())
+		{
+			ASSERT_FALSE(x.try_push_front(i));
+			x.pop_back();
+			y.pop_back();
+		}
+		ASSERT_TRUE((i % 3 == 0) ? x.try_push_back(i) : x.try_push_front(i));
+		(i % 3 == 0) ? y.push_back(i) : y.push_front(i);
+		ASSERT_EQ(x.size(), y.size());
+		ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	}
+	ASSERT_EQ(x.front(), y.front());
+	ASSERT_EQ(x.back(), y.back());
+	ASSERT_THROW(x.at(8), std::out_of_range);
+	x.clear();
+	ASSERT_TRUE(x.empty());
+}
+
+TEST(StaticDequeTest, insert_erase)
+{
+	StaticDeque<std::string, 6> x(3, "a");
+	x.pop_front();
+	x.push_back("b");
+	x.insert(x.begin() + 1, "c");
+	x.insert(x.begin() + 3, x[0]);
+	x.insert(x.end(), "d");
+	std::deque<std::string> y = {"a", "c", "a", "a", "b", "d"};
+	ASSERT_TRUE(x.full());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_EQ(*x.erase(x.begin() + 1), "a");
+	ASSERT_EQ(*x.erase(x.begin() + 3), "d");
+	y = {"a", "a", "a", "d"};
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	StaticDeque<std::string, 6> z = {"a", "a", "a", "d"};
+	ASSERT_TRUE(x == z);
+	z.back() = "e";
+	ASSERT_TRUE(x < z);
+	x.swap(z);
+	ASSERT_EQ(x.back(), "e");
+}
+
+TEST(SoaDequeTest, push_pop)
+{
+	SoaDeque<int, double, std::string> x;
+	std::deque<std::tuple<int, double, std::string> > y;
+	for(int i = 0; i != 5 * SIZET; ++i)
+	{
+		std::tuple<int, double, std::string> v(i, i / 2.0, std::to_string(i));
+		(i % 3 == 0) ? x.push_front(v) : x.push_back(v);
+		(i % 3 == 0) ? y.push_front(v) : y.push_back(v);
+		if(i % 7 == 6)
+		{
+			x.pop_front();
+			y.pop_front();
+		}
+		if(i % 11 == 10)
+		{
+			x.pop_back();
+			y.pop_back();
+		}
+	}
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_TRUE(x.front() == y.front());
+	ASSERT_TRUE(x.back() == y.back());
+	ASSERT_THROW(x.at(x.size()), std::out_of_range);
+	SoaDeque<int, double, std::string> z = x;
+	ASSERT_TRUE(z == x);
+	z.clear();
+	ASSERT_TRUE(z.empty());
+	ASSERT_TRUE(z < x);
+	z = x;
+	ASSERT_TRUE(z == x);
+}
+
+TEST(SoaDequeTest, proxy)
+{
+	SoaDeque<int, std::string> x;
+	for(int i = 0; i != 10; ++i)
+		x.push_back(std::make_tuple(i, std::string(i, 'a')));
+	x[3] = std::make_tuple(30, std::string("b"));
+	std::get<1>(x[4]) = "c";
+	x.get<0>(5) = 50;
+	int n;
+	std::string s;
+	std::tie(n, s) = x[3];
+	ASSERT_EQ(n, 30);
+	ASSERT_EQ(s, "b");
+	const SoaDeque<int, std::string>& y = x;
+	ASSERT_EQ(std::get<1>(y[4]), "c");
+	ASSERT_EQ(y.get<0>(5), 50);
+	std::tuple<int, std::string> v = y.at(6);
+	ASSERT_EQ(std::get<1>(v), "aaaaaa");
+}
+
+TEST(SoaDequeTest, column_segments)
+{
+	SoaDeque<long, char> x;
+	for(int i = 0; i != 3 * SIZET; ++i)
+		x.push_front(std::make_tuple(static_cast<long>(i), 'a'));
+	int segments = 0;
+	long sum = 0;
+	x.for_each_segment<0>(10, x.size() - 10, [&] (const long* b, const long* e)
+	{
+		++segments;
+		sum = std::accumulate(b, e, sum);
+	});
+	long expected = 0;
+	for(std::size_t i = 10; i != x.size() - 10; ++i)
+		expected += x.get<0>(i);
+	ASSERT_EQ(sum, expected);
+	ASSERT_GE(segments, 3);
+	x.for_each_segment<1>(0, x.size(), [] (char* b, char* e)
+	{
+		std::fill(b, e, 'b');
+	});
+	ASSERT_EQ(std::get<1>(x[SIZET]), 'b');
+	ASSERT_EQ(std::get<1>(x.back()), 'b');
+}
+
+TEST(SoaDequeTest, allocator)
+{
+	BasicSoaDeque<Aligned_Allocator<std::tuple<char, double>, 64>, char, double> x;
+	for(int i = 0; i != 2 * SIZET; ++i)
+		x.push_back(std::make_tuple('a', 1.0 * i));
+	ASSERT_EQ(reinterpret_cast<uintptr_t>(&x.get<0>(0)) % 64, 0);
+	ASSERT_EQ(reinterpret_cast<uintptr_t>(&x.get<1>(SIZET)) % 64, 0);
+	ASSERT_EQ(x.get<1>(SIZET + 1), SIZET + 1);
+}
+
+///
+/// A field whose copy constructor throws while fail is set, counting the live instances
+///
+struct SoaField
+{
+	static int live;
+	static bool fail;
+
+	SoaField ()
+	{
+		++live;
+	}
+
+	SoaField (const SoaField&)
+	{
+		if(fail)
+			throw std::runtime_error("SoaField");
+		++live;
+	}
+
+	~SoaField ()
+	{
+		--live;
+	}
+};
+
+int SoaField::live = 0;
+bool SoaField::fail = false;
+
+TEST(SoaDequeTest, throwing_column)
+{
+	{
+		SoaDeque<SoaField, std::string, SoaField> x;
+		std::tuple<SoaField, std::string, SoaField> v;
+		x.push_back(v);
+		x.push_front(v);
+		ASSERT_EQ(SoaField::live, 6);
+		SoaField::fail = true;
+		ASSERT_THROW(x.push_back(v), std::runtime_error);
+		ASSERT_THROW(x.push_front(v), std::runtime_error);
+		SoaField::fail = false;
+		ASSERT_EQ(SoaField::live, 6);
+		ASSERT_EQ(x.size(), 2);
+		x.push_front(v);
+		x.pop_back();
+		ASSERT_EQ(x.size(), 2);
+		ASSERT_EQ(SoaField::live, 6);
+	}
+	ASSERT_EQ(SoaField::live, 0);
+}
+
+TEST(DequeBatchTest, pop_n)
+{
+	MyDeque<std::string> x;
+	std::deque<std::string> y;
+	for(int i = 0; i != 5 * SIZET; ++i)
+	{
+		(i % 2) ? x.push_back(std::to_string(i)) : x.push_front(std::to_string(i));
+		(i % 2) ? y.push_back(std::to_string(i)) : y.push_front(std::to_string(i));
+	}
+	std::vector<std::string> v;
+	x.pop_front_n(1500, std::back_inserter(v));
+	ASSERT_TRUE(std::equal(v.begin(), v.end(), y.begin()));
+	y.erase(y.begin(), y.begin() + 1500);
+	v.clear();
+	x.pop_back_n(1700, std::back_inserter(v));
+	ASSERT_TRUE(std::equal(v.begin(), v.end(), y.end() - 1700));
+	y.erase(y.end() - 1700, y.end());
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	x.push_front("a");
+	x.push_back("b");
+	ASSERT_EQ(x.front(), "a");
+	ASSERT_EQ(x.back(), "b");
+	x.pop_front_n(x.size(), std::back_inserter(v));
+	ASSERT_TRUE(x.empty());
+	x.push_back("c");
+	ASSERT_EQ(x.front(), "c");
+}
+
+TEST(DequeBatchTest, take_front_block)
+{
+	MyDeque<std::string> x;
+	for(int i = 0; i != 3 * SIZET; ++i)
+		x.push_back(std::to_string(i));
+	x.pop_front();
+	MyDeque<std::string>::block_span s = x.take_front_block();
+	ASSERT_EQ(s.size(), SIZET - 1);
+	ASSERT_EQ(s[0], "1");
+	ASSERT_EQ(*(s.end() - 1), std::to_string(SIZET - 1));
+	ASSERT_EQ(x.size(), 2 * SIZET);
+	ASSERT_EQ(x.front(), std::to_string(SIZET));
+	std::string* p = s.begin();
+	x.recycle(std::move(s));
+	ASSERT_TRUE(s.empty());
+	MyDeque<std::string>::block_span t = x.take_front_block();
+	ASSERT_EQ(t.size(), SIZET);
+	ASSERT_EQ(t[0], std::to_string(SIZET));
+	for(int i = 0; i != 2 * SIZET; ++i)
+		x.push_back("a");
+	ASSERT_EQ(x.size(), 3 * SIZET);
+	ASSERT_EQ(x[3 * SIZET - 1], "a");
+	bool reused = false;
+	for(std::size_t i = 0; i != x.size(); ++i)
+		reused = reused || (&x[i] == p + 1);
+	ASSERT_TRUE(reused);
+	MyDeque<std::string> y;
+	ASSERT_TRUE(y.take_front_block().empty());
+}
+
+TEST(DequeBatchTest, take_front_block_spill)
+{
+	MyDeque<int> x;
+	x.set_memory_budget(4 * SIZET * sizeof(int), "TestDeque.spill");
+	for(int i = 0; i < 20 * SIZET; ++i)
+		x.push_back(i);
+	int n = 0;
+	while(!x.empty())
+	{
+		MyDeque<int>::block_span s = x.take_front_block();
+		ASSERT_EQ(s.size(), SIZET);
+		for(int* p = s.begin(); p != s.end(); ++p)
+			ASSERT_EQ(*p, n++);
+	}
+	ASSERT_EQ(n, 20 * SIZET);
+}
+
+TEST(DequeBatchTest, take_front_block_fixed_capacity)
+{
+	MyDeque<int> x(3 * SIZET, MyDeque<int>::reject);
+	for(int i = 0; i != 2 * SIZET; ++i)
+		x.push_back(i);
+	std::size_t allocations = x.stats().block_allocations;
+	ASSERT_THROW(x.take_front_block(), std::length_error);
+	ASSERT_EQ(x.size(), 2 * SIZET);
+	MyDeque<int> y(SIZET, 0);
+	x.recycle(y.take_front_block());
+	MyDeque<int>::block_span s = x.take_front_block();
+	ASSERT_EQ(s.size(), SIZET);
+	ASSERT_EQ(s[0], 0);
+	ASSERT_EQ(x.front(), SIZET);
+	ASSERT_EQ(x.stats().block_allocations, allocations);
+	x.recycle(std::move(s));
+	ASSERT_EQ(x.take_front_block().size(), SIZET);
+	ASSERT_TRUE(x.empty());
+}
+
+TEST(DequeSegmentViewTest, segments)
+{
+	MyDeque<int> x;
+	for(int i = 0; i != 3 * SIZET; ++i)
+		x.push_back(i);
+	for(int i = 1; i <= 10; ++i)
+		x.push_front(-i);
+	MyDeque<int>::segment_view<MyDeque<int>, int*> v = x.segments(x.begin() + 5, x.end() - 7);
+	ASSERT_EQ(v.size(), 4);
+	ASSERT_EQ(v.bytes(), (x.size() - 12) * sizeof(int));
+	std::vector<int> y;
+	std::size_t n = 0;
+	for(MyDeque<int>::segment_view<MyDeque<int>, int*>::iterator i = v.begin(); i != v.end(); ++i, ++n)
+	{
+		std::pair<int*, std::size_t> s = *i;
+		ASSERT_TRUE(n == 0 || n == 3 || s.second == SIZET);
+		y.insert(y.end(), s.first, s.first + s.second);
+	}
+	ASSERT_EQ(n, v.size());
+	ASSERT_TRUE(std::equal(y.begin(), y.end(), x.begin() + 5));
+	ASSERT_EQ(y.size(), x.size() - 12);
+	const MyDeque<int>& z = x;
+	ASSERT_EQ(z.segments(z.begin() + 3, z.begin() + 3).size(), 0);
+	ASSERT_EQ(z.segments().size(), 4);
+	MyDeque<int> empty;
+	ASSERT_EQ(empty.segments().size(), 0);
+	ASSERT_TRUE(empty.segments().iovecs().empty());
+}
+
+TEST(DequeSegmentViewTest, writev)
+{
+	MyDeque<int> x;
+	for(int i = 0; i != 5 * SIZET / 2; ++i)
+		(i % 2) ? x.push_back(i) : x.push_front(i);
+	std::vector<iovec> v = x.segments().iovecs();
+	ASSERT_EQ(v.size(), x.segments().size());
+	FILE* f = tmpfile();
+	std::size_t written = 0;
+	for(std::size_t i = 0; i != v.size(); )
+	{
+		ssize_t r = writev(fileno(f), &v[i], v.size() - i);
+		ASSERT_GT(r, 0);
+		written += r;
+		for(; i != v.size() && static_cast<std::size_t>(r) >= v[i].iov_len; ++i)
+			r -= v[i].iov_len;
+		if(i != v.size())
+		{
+			v[i].iov_base = static_cast<char*>(v[i].iov_base) + r;
+			v[i].iov_len -= r;
+		}
+	}
+	std::vector<int> y(x.size());
+	rewind(f);
+	ASSERT_EQ(fread(&y[0], sizeof(int), y.size(), f), y.size());
+	fclose(f);
+	ASSERT_EQ(written, x.size() * sizeof(int));
+	ASSERT_TRUE(std::equal(y.begin(), y.end(), x.begin()));
+	MyDeque<int> s;
+	s.set_memory_budget(0, "TestDeque.spill");
+	ASSERT_THROW(s.segments().iovecs(), std::logic_error);
+}
+
+TEST(DequeSegmentViewTest, grow_back_uninitialized)
+{
+	FILE* f = tmpfile();
+	std::vector<int> y(5 * SIZET / 2);
+	for(std::size_t i = 0; i != y.size(); ++i)
+		y[i] = i * 7;
+	ASSERT_EQ(fwrite(&y[0], sizeof(int), y.size(), f), y.size());
+	rewind(f);
+	MyDeque<int> x;
+	x.push_back(-1);
+	x.push_front(-2);
+	MyDeque<int>::segment_view<MyDeque<int>, int*> v = x.grow_back_uninitialized(y.size() + 100);
+	ASSERT_EQ(x.size(), 2);
+	std::vector<iovec> w = v.iovecs();
+	ASSERT_GE(w.size(), 3);
+	ssize_t r = readv(fileno(f), &w[0], w.size());
+	fclose(f);
+	ASSERT_EQ(r, y.size() * sizeof(int));
+	x.commit_back(r / sizeof(int));
+	ASSERT_EQ(x.size(), y.size() + 2);
+	ASSERT_EQ(x[0], -2);
+	ASSERT_EQ(x[1], -1);
+	ASSERT_TRUE(std::equal(y.begin(), y.end(), x.begin() + 2));
+	x.push_back(5);
+	ASSERT_EQ(x.back(), 5);
+	MyDeque<int> z(4, MyDeque<int>::reject);
+	ASSERT_THROW(z.grow_back_uninitialized(5), std::length_error);
+	MyDeque<int>::segment_view<MyDeque<int>, int*> u = z.grow_back_uninitialized(4);
+	*(*u.begin()).first = 9;
+	z.commit_back(1);
+	ASSERT_EQ(z.front(), 9);
+}
+
+TEST(DequeSpliceTest, append)
+{
+	for(int n : {0, 1, 999, 1000, 2500})
+		for(int m : {0, 1, 1000, 3001})
+		{
+			MyDeque<std::string> x;
+			MyDeque<std::string> y;
+			std::deque<std::string> z;
+			for(int i = 0; i != n; ++i)
+			{
+				(i % 3) ? x.push_back(std::to_string(i)) : x.push_front(std::to_string(i));
+				(i % 3) ? z.push_back(std::to_string(i)) : z.push_front(std::to_string(i));
+			}
+			std::deque<std::string> w;
+			for(int i = 0; i != m; ++i)
+			{
+				(i % 2) ? y.push_back(std::to_string(-i)) : y.push_front(std::to_string(-i));
+				(i % 2) ? w.push_back(std::to_string(-i)) : w.push_front(std::to_string(-i));
+			}
+			std::string* p = (m > n) ? &y[m / 2] : nullptr;
+			x.append(std::move(y));
+			z.insert(z.end(), w.begin(), w.end());
+			ASSERT_TRUE(y.empty());
+			ASSERT_EQ(x.size(), z.size());
+			ASSERT_TRUE(std::equal(x.begin(), x.end(), z.begin()));
+			if(p != nullptr)
+			{
+				ASSERT_EQ(&x[n + m / 2], p);
+			}
+			x.push_back("a");
+			x.push_front("b");
+			y.push_back("c");
+			ASSERT_EQ(x.back(), "a");
+			ASSERT_EQ(x.front(), "b");
+			ASSERT_EQ(y.front(), "c");
+		}
+}
+
+TEST(DequeSpliceTest, prepend)
+{
+	for(int n : {0, 1, 999, 1000, 2500})
+		for(int m : {0, 1, 1000, 3001})
+		{
+			MyDeque<std::string> x;
+			MyDeque<std::string> y;
+			std::deque<std::string> z;
+			for(int i = 0; i != n; ++i)
+			{
+				(i % 3) ? x.push_back(std::to_string(i)) : x.push_front(std::to_string(i));
+				(i % 3) ? z.push_back(std::to_string(i)) : z.push_front(std::to_string(i));
+			}
+			std::deque<std::string> w;
+			for(int i = 0; i != m; ++i)
+			{
+				(i % 2) ? y.push_back(std::to_string(-i)) : y.push_front(std::to_string(-i));
+				(i % 2) ? w.push_back(std::to_string(-i)) : w.push_front(std::to_string(-i));
+			}
+			std::string* p = (n >= m && n != 0) ? &x[n / 2] : nullptr;
+			x.prepend(std::move(y));
+			z.insert(z.begin(), w.begin(), w.end());
+			ASSERT_TRUE(y.empty());
+			ASSERT_EQ(x.size(), z.size());
+			ASSERT_TRUE(std::equal(x.begin(), x.end(), z.begin()));
+			if(p != nullptr)
+			{
+				ASSERT_EQ(&x[m + n / 2], p);
+			}
+			x.push_back("a");
+			x.push_front("b");
+			ASSERT_EQ(x.back(), "a");
+			ASSERT_EQ(x.front(), "b");
+		}
+}
+
+TEST(DequeSpliceTest, aligned_seams)
+{
+	for(int n : {1, 1000, 2999})
+		for(int m : {1, 500, 4000})
+		{
+			MyDeque<std::string> x;
+			MyDeque<std::string> y;
+			std::deque<std::string> z;
+			std::deque<std::string> w;
+			for(int i = 0; i != n; ++i)
+			{
+				x.push_back(std::to_string(i));
+				z.push_back(std::to_string(i));
+			}
+			for(int i = 0; i != m + SIZET; ++i)
+			{
+				y.push_back(std::to_string(-i));
+				w.push_back(std::to_string(-i));
+			}
+			while(y.b != x.e)
+			{
+				y.pop_front();
+				w.pop_front();
+			}
+			std::string* p = (x.e == 0 || y.b + y.size() > USIZET) ? &y.back() : nullptr;
+			x.append(std::move(y));
+			z.insert(z.end(), w.begin(), w.end());
+			ASSERT_TRUE(y.empty());
+			ASSERT_TRUE(std::equal(x.begin(), x.end(), z.begin()));
+			ASSERT_EQ(x.size(), z.size());
+			if(p != nullptr)
+			{
+				ASSERT_EQ(&x.back(), p);
+			}
+			y.push_back("a");
+			ASSERT_EQ(y.front(), "a");
+			y.pop_back();
+			w.clear();
+			for(int i = 0; i != m + SIZET; ++i)
+			{
+				y.push_front(std::to_string(i));
+				w.push_front(std::to_string(i));
+			}
+			while(y.e != x.b)
+			{
+				y.pop_back();
+				w.pop_back();
+			}
+			p = (x.b == 0 || y.size() > static_cast<std::size_t>(x.b)) ? &y.front() : nullptr;
+			x.prepend(std::move(y));
+			z.insert(z.begin(), w.begin(), w.end());
+			ASSERT_TRUE(y.empty());
+			ASSERT_TRUE(std::equal(x.begin(), x.end(), z.begin()));
+			ASSERT_EQ(x.size(), z.size());
+			if(p != nullptr)
+			{
+				ASSERT_EQ(&x.front(), p);
+			}
+			x.push_back("b");
+			x.push_front("c");
+			ASSERT_EQ(x.back(), "b");
+			ASSERT_EQ(x.front(), "c");
+		}
+}
+
+TEST(DequeSpliceTest, fixed_capacity)
+{
+	MyDeque<int> x(3000, MyDeque<int>::reject);
+	MyDeque<int> y;
+	for(int i = 0; i != 2000; ++i)
+	{
+		x.push_back(i);
+		y.push_back(-i);
+	}
+	ASSERT_THROW(x.append(std::move(y)), std::length_error);
+	y.resize(1000);
+	x.prepend(std::move(y));
+	ASSERT_TRUE(x.full());
+	ASSERT_EQ(x[0], 0);
+	ASSERT_EQ(x[999], -999);
+	ASSERT_EQ(x[1000], 0);
+	ASSERT_EQ(x.back(), 1999);
+}
+
+TEST(DequeSpliceTest, split_off)
+{
+	for(int n : {1, 999, 1000, 2500, 4000})
+		for(int f : {0, 1, 500})
+			for(int i : {0, 1, 500, 999, 1000, 1001, 2000, 4000})
+			{
+				if(i > n + f)
+					continue;
+				MyDeque<std::string> x;
+				std::deque<std::string> z;
+				for(int j = 0; j != n; ++j)
+				{
+					x.push_back(std::to_string(j));
+					z.push_back(std::to_string(j));
+				}
+				for(int j = 0; j != f; ++j)
+				{
+					x.push_front(std::to_string(-j));
+					z.push_front(std::to_string(-j));
+				}
+				std::string* p = (i + 1500 < n + f) ? &x[i + 1500] : nullptr;
+				MyDeque<std::string> y = x.split_off(x.begin() + i);
+				ASSERT_EQ(x.size(), i);
+				ASSERT_EQ(y.size(), z.size() - i);
+				ASSERT_TRUE(std::equal(x.begin(), x.end(), z.begin()));
+				ASSERT_TRUE(std::equal(y.begin(), y.end(), z.begin() + i));
+				if(p != nullptr)
+				{
+					ASSERT_EQ(&y[1500], p);
+				}
+				for(int j = 0; j != 1500; ++j)
+				{
+					x.push_back("a");
+					y.push_front("b");
+					x.push_front("c");
+					y.push_back("d");
+				}
+				ASSERT_EQ(x.back(), "a");
+				ASSERT_EQ(y.front(), "b");
+				ASSERT_EQ(x.front(), "c");
+				ASSERT_EQ(y.back(), "d");
+			}
+}
+
+TEST(DequeSpliceTest, split_off_fixed_capacity)
+{
+	MyDeque<int> x(3000, MyDeque<int>::reject);
+	for(int i = 0; i != 2500; ++i)
+		x.push_back(i);
+	MyDeque<int> y = x.split_off(x.begin() + 1200);
+	ASSERT_EQ(x.size(), 1200);
+	ASSERT_EQ(y.size(), 1300);
+	ASSERT_EQ(x.back(), 1199);
+	ASSERT_EQ(y.front(), 1200);
+	x.resize(3000);
+	ASSERT_TRUE(x.full());
+}
+
+///
+/// An element that counts its copies
+///
+struct SplitCopies
+{
+	static int copies;
+
+	SplitCopies ()
+	{}
+
+	SplitCopies (const SplitCopies&)
+	{
+		++copies;
+	}
+
+	SplitCopies (SplitCopies&&)
+	{}
+
+	SplitCopies& operator = (const SplitCopies&)
+	{
+		++copies;
+		return *this;
+	}
+};
+
+int SplitCopies::copies = 0;
+
+TEST(DequeSpliceTest, split_off_moves)
+{
+	MyDeque<SplitCopies> x(3000, MyDeque<SplitCopies>::reject);
+	x.resize(2500);
+	SplitCopies::copies = 0;
+	MyDeque<SplitCopies> y = x.split_off(x.begin() + 1200);
+	ASSERT_EQ(x.size(), 1200);
+	ASSERT_EQ(y.size(), 1300);
+	ASSERT_EQ(SplitCopies::copies, 0);
+	MyDeque<int> z;
+	z.set_memory_budget(8 * SIZET * sizeof(int), "TestDeque.spill");
+	for(int i = 0; i != 20 * SIZET; ++i)
+		z.push_back(i);
+	MyDeque<int> w = z.split_off(z.begin() + 5 * SIZET + 5);
+	ASSERT_EQ(z.size(), 5 * SIZET + 5);
+	ASSERT_EQ(w.size(), 15 * SIZET - 5);
+	ASSERT_EQ(z.back(), 5 * SIZET + 4);
+	for(int i = 0; i != 15 * SIZET - 5; ++i)
+		ASSERT_EQ(w[i], 5 * SIZET + 5 + i);
+}
+
+TEST(CowDequeTest, snapshot)
+{
+	CowDeque<std::string> x;
+	for(int i = 0; i != 5 * SIZET; ++i)
+		x.push_back(std::to_string(i));
+	x.pop_front();
+	CowDeque<std::string> y = x;
+	const CowDeque<std::string>& z = x;
+	const CowDeque<std::string>& r = y;
+	ASSERT_EQ(z.shared_blocks(), 5);
+	ASSERT_EQ(&z[100], &r[100]);
+	x[100] = "a";
+	ASSERT_EQ(z.shared_blocks(), 4);
+	ASSERT_EQ(r[100], "101");
+	ASSERT_EQ(x[100], "a");
+	x.push_back("b");
+	x.push_front("c");
+	x.pop_back();
+	ASSERT_EQ(z.shared_blocks(), 4);
+	ASSERT_EQ(y.shared_blocks(), 4);
+	ASSERT_EQ(y.size(), 5 * SIZET - 1);
+	ASSERT_EQ(r.back(), std::to_string(5 * SIZET - 1));
+	ASSERT_EQ(x.size(), 5 * SIZET);
+	ASSERT_EQ(x.front(), "c");
+	CowDeque<std::string> w;
+	w = y;
+	ASSERT_TRUE(w == y);
+	y.clear();
+	ASSERT_EQ(w.shared_blocks(), 4);
+	x.clear();
+	ASSERT_EQ(w.shared_blocks(), 0);
+	ASSERT_EQ(w.back(), std::to_string(5 * SIZET - 1));
+	ASSERT_EQ(w[100], "101");
+}
+
+TEST(CowDequeTest, diverge)
+{
+	CowDeque<int> x;
+	std::deque<int> y;
+	std::vector<CowDeque<int> > snapshots;
+	std::vector<std::deque<int> > expected;
+	for(int i = 0; i != 20 * SIZET; ++i)
+	{
+		switch(i % 5)
+		{
+			case 0: case 1:
+				x.push_back(i);
+				y.push_back(i);
+				break;
+			case 2:
+				x.push_front(i);
+				y.push_front(i);
+				break;
+			case 3:
+				x.pop_front();
+				y.pop_front();
+				break;
+			case 4:
+				x[i % x.size()] = -i;
+				y[i % y.size()] = -i;
+				break;
+		}
+		if(i % 1777 == 0)
+		{
+			snapshots.push_back(x);
+			expected.push_back(y);
+		}
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	for(std::size_t i = 0; i != snapshots.size(); ++i)
+	{
+		ASSERT_EQ(snapshots[i].size(), expected[i].size());
+		const CowDeque<int>& s = snapshots[i];
+		ASSERT_TRUE(std::equal(s.begin(), s.end(), expected[i].begin()));
+	}
+	x.resize(10);
+	ASSERT_EQ(x.size(), 10);
+	ASSERT_THROW(x.at(10), std::out_of_range);
+	int sum = 0;
+	x.for_each_segment(0, x.size(), [&sum] (const int* b, const int* e)
+	{
+		sum = std::accumulate(b, e, sum);
+	});
+	ASSERT_EQ(sum, std::accumulate(y.begin(), y.begin() + 10, 0));
+}
+
+TEST(LogDequeTest, push_back)
+{
+	LogDeque<std::string> x;
+	ASSERT_TRUE(x.empty());
+	for(int i = 0; i != 10 * SIZET; ++i)
+		x.push_back(std::to_string(i));
+	ASSERT_EQ(x.size(), 10 * SIZET);
+	ASSERT_EQ(x.front(), "0");
+	ASSERT_EQ(x.back(), std::to_string(10 * SIZET - 1));
+	ASSERT_EQ(x.at(1234), "1234");
+	ASSERT_THROW(x.at(10 * SIZET), std::out_of_range);
+	const std::string* p = &x[5];
+	for(int i = 0; i != 50 * SIZET; ++i)
+		x.push_back("a");
+	ASSERT_EQ(&x[5], p);
+	int n = 0;
+	for(LogDeque<std::string>::const_iterator i = x.begin(); i != x.end(); ++i)
+		++n;
+	ASSERT_EQ(n, 60 * SIZET);
+}
+
+TEST(LogDequeTest, concurrent_readers)
+{
+	LogDeque<long> x;
+	const long n = 200 * SIZET;
+	bool ok = true;
+	std::vector<std::thread> readers;
+	for(int t = 0; t != 4; ++t)
+		readers.push_back(std::thread([&x, &ok, n, t] ()
+		{
+			std::size_t seen = 0;
+			while(seen != static_cast<std::size_t>(n))
+			{
+				std::size_t s = x.size();
+				if(s == 0)
+					continue;
+				if(x[s - 1] != static_cast<long>(s - 1) || x[(s - 1) * t / 4] != static_cast<long>((s - 1) * t / 4))
+					__atomic_store_n(&ok, false, __ATOMIC_RELAXED);
+				long sum = 0;
+				x.for_each_segment(seen, s, [&sum] (const long* b, const long* e)
+				{
+					sum = std::accumulate(b, e, sum);
+				});
+				long lo = seen;
+				long hi = s;
+				if(sum != (hi * (hi - 1) - lo * (lo - 1)) / 2)
+					__atomic_store_n(&ok, false, __ATOMIC_RELAXED);
+				seen = s;
+			}
+		}));
+	for(long i = 0; i != n; ++i)
+		x.push_back(i);
+	for(std::size_t t = 0; t != readers.size(); ++t)
+		readers[t].join();
+	ASSERT_TRUE(ok);
+	ASSERT_EQ(x.size(), n);
+	ASSERT_EQ(x.back(), n - 1);
+}
+
+// -----------
+// ChannelTest
+// -----------
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+// A coroutine that starts at once and frees its frame when it finishes
+struct ChannelTask
+{
+	struct promise_type
+	{
+		ChannelTask get_return_object ()
+		{
+			return ChannelTask();
+		}
+
+		std::suspend_never initial_suspend () noexcept
+		{
+			return std::suspend_never();
+		}
+
+		std::suspend_never final_suspend () noexcept
+		{
+			return std::suspend_never();
+		}
+
+		void return_void ()
+		{}
+
+		void unhandled_exception ()
+		{
+			std::terminate();
+		}
+	};
+};
+
+ChannelTask channel_producer (Channel<int>& c, int n, bool& done)
+{
+	for(int i = 0; i != n; ++i)
+		if(!co_await c.push(i))
+			break;
+	c.close();
+	done = true;
+}
+
+ChannelTask channel_consumer (Channel<int>& c, std::vector<int>& out)
+{
+	while(true)
+	{
+		std::optional<int> v = co_await c.pop();
+		if(!v)
+			break;
+		out.push_back(*v);
+	}
+}
+
+ChannelTask channel_batch_consumer (Channel<int>& c, std::size_t n, std::vector<std::size_t>& sizes, std::vector<int>& out)
+{
+	while(true)
+	{
+		std::vector<int> v = co_await c.pop_n(n);
+		if(v.empty())
+			break;
+		sizes.push_back(v.size());
+		out.insert(out.end(), v.begin(), v.end());
+	}
+}
+
+TEST(ChannelTest, producer_consumer)
+{
+	LocalExecutor ex;
+	Channel<int> c(4, ex);
+	std::vector<int> out;
+	bool done = false;
+	channel_consumer(c, out);
+	channel_producer(c, 2500, done);
+	ASSERT_LE(c.size(), 4u);
+	ex.run();
+	ASSERT_TRUE(done);
+	ASSERT_EQ(out.size(), 2500u);
+	for(int i = 0; i != 2500; ++i)
+		ASSERT_EQ(out[i], i);
+	ASSERT_EQ(c.size(), 0u);
+}
+
+TEST(ChannelTest, close)
+{
+	LocalExecutor ex;
+	Channel<int> c(2, ex);
+	std::vector<int> a;
+	std::vector<int> b;
+	channel_consumer(c, a);
+	channel_consumer(c, b);
+	ASSERT_EQ(ex.run(), 0u);
+	c.close();
+	ASSERT_EQ(ex.run(), 2u);
+	ASSERT_TRUE(a.empty());
+	ASSERT_TRUE(b.empty());
+	ASSERT_FALSE(c.try_push(1));
+	bool done = false;
+	channel_producer(c, 1, done);
+	ASSERT_TRUE(done);
+	ASSERT_EQ(c.size(), 0u);
+}
+
+TEST(ChannelTest, close_drains)
+{
+	LocalExecutor ex;
+	Channel<int> c(8, ex);
+	ASSERT_TRUE(c.try_push(1));
+	ASSERT_TRUE(c.try_push(2));
+	c.close();
+	std::vector<int> out;
+	channel_consumer(c, out);
+	ASSERT_EQ(out, std::vector<int>({1, 2}));
+}
+
+TEST(ChannelTest, pop_n)
+{
+	LocalExecutor ex;
+	Channel<int> c(3000, ex);
+	std::vector<std::size_t> sizes;
+	std::vector<int> out;
+	for(int i = 0; i != 2500; ++i)
+		ASSERT_TRUE(c.try_push(i));
+	c.close();
+	channel_batch_consumer(c, 1000, sizes, out);
+	ASSERT_EQ(sizes, std::vector<std::size_t>({1000, 1000, 500}));
+	ASSERT_EQ(out.size(), 2500u);
+	for(int i = 0; i != 2500; ++i)
+		ASSERT_EQ(out[i], i);
+}
+
+TEST(ChannelTest, pop_n_wakes_pushes)
+{
+	LocalExecutor ex;
+	Channel<int> c(2, ex);
+	std::vector<std::size_t> sizes;
+	std::vector<int> out;
+	bool done = false;
+	channel_producer(c, 10, done);
+	ASSERT_FALSE(done);
+	ASSERT_EQ(c.size(), 2u);
+	channel_batch_consumer(c, 5, sizes, out);
+	ex.run();
+	ASSERT_TRUE(done);
+	ASSERT_EQ(out.size(), 10u);
+	for(int i = 0; i != 10; ++i)
+		ASSERT_EQ(out[i], i);
+}
+
+TEST(ChannelTest, try_push_try_pop)
+{
+	LocalExecutor ex;
+	Channel<std::string> c(2, ex);
+	ASSERT_FALSE(c.try_pop());
+	ASSERT_TRUE(c.try_push("a"));
+	ASSERT_TRUE(c.try_push("b"));
+	ASSERT_FALSE(c.try_push("c"));
+	ASSERT_EQ(c.size(), 2u);
+	ASSERT_EQ(*c.try_pop(), "a");
+	ASSERT_EQ(*c.try_pop(), "b");
+	ASSERT_FALSE(c.try_pop());
+}
+
+TEST(ChannelTest, rendezvous)
+{
+	LocalExecutor ex;
+	Channel<int> c(0, ex);
+	ASSERT_FALSE(c.try_push(1));
+	bool done = false;
+	channel_producer(c, 3, done);
+	ASSERT_EQ(c.size(), 0u);
+	ASSERT_EQ(*c.try_pop(), 0);
+	ex.run();
+	std::vector<int> out;
+	channel_consumer(c, out);
+	ex.run();
+	ASSERT_TRUE(done);
+	ASSERT_EQ(out, std::vector<int>({1, 2}));
+}
+
+#else
+
+// Channel.h is empty before C++20; build TestDeque20 to run the ChannelTest cases
+TEST(ChannelTest, skipped)
+{
+	GTEST_SKIP() << "Channel needs C++20 coroutines; build TestDeque20";
+}
+
+#endif // __cpp_impl_coroutine
+
+// ---------------
+// WindowDequeTest
+// ---------------
+
+TEST(WindowDequeTest, aggregates)
+{
+	WindowDeque<int> x;
+	std::deque<int> y;
+	srand(48);
+	for(int i = 0; i != 5000; ++i)
+	{
+		x.push_back(rand() % 100 - 50);
+		y.push_back(x.back());
+		if(y.size() > 257 || (i % 13 == 12 && !y.empty()))
+		{
+			x.pop_front();
+			y.pop_front();
+		}
+		ASSERT_EQ(x.size(), y.size());
+		ASSERT_EQ(x.min(), *std::min_element(y.begin(), y.end()));
+		ASSERT_EQ(x.max(), *std::max_element(y.begin(), y.end()));
+		ASSERT_EQ(x.sum(), std::accumulate(y.begin(), y.end(), 0));
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	ASSERT_LE(x.mins.size(), x.size());
+	x.clear();
+	ASSERT_TRUE(x.empty());
+	ASSERT_TRUE(x.mins.empty());
+	ASSERT_EQ(x.sum(), 0);
+}
+
+TEST(WindowDequeTest, duplicates)
+{
+	WindowDeque<int> x;
+	x.push_back(3);
+	x.push_back(1);
+	x.push_back(1);
+	x.push_back(3);
+	ASSERT_EQ(x.min(), 1);
+	ASSERT_EQ(x.max(), 3);
+	x.pop_front();
+	ASSERT_EQ(x.max(), 3);
+	x.pop_front();
+	ASSERT_EQ(x.min(), 1);
+	x.pop_front();
+	ASSERT_EQ(x.min(), 3);
+	ASSERT_EQ(x.sum(), 3);
+}
+
+TEST(WindowDequeTest, compensated_sum)
+{
+	WindowDeque<double> x;
+	x.push_back(1e16);
+	for(int i = 0; i != 1000; ++i)
+		x.push_back(1.0);
+	x.pop_front();
+	ASSERT_EQ(x.sum(), 1000.0);
+	ASSERT_EQ(x.min(), 1.0);
+	ASSERT_EQ(x.max(), 1.0);
+	while(!x.empty())
+		x.pop_front();
+	ASSERT_EQ(x.sum(), 0.0);
+}
+
+// ---------------
+// PackedDequeTest
+// ---------------
+
+TEST(PackedDequeTest, timestamps)
+{
+	PackedDeque<std::int64_t> x;
+	std::deque<std::int64_t> y;
+	srand(49);
+	std::int64_t t = 1700000000000000000LL;
+	for(int i = 0; i != 100000; ++i)
+	{
+		t += 1000000 + rand() % 2001 - 1000;
+		x.push_back(t);
+		y.push_back(t);
+	}
+	ASSERT_EQ(x.size(), y.size());
+	ASSERT_LT(4 * x.storage(), x.size() * sizeof(std::int64_t));
+	for(int i = 0; i != 10000; ++i)
+	{
+		std::size_t j = rand() % y.size();
+		ASSERT_EQ(x[j], y[j]);
+	}
+	std::vector<std::int64_t> z;
+	x.for_each_segment(0, x.size(), [&z] (const std::int64_t* b, const std::int64_t* e)
+	{
+		z.insert(z.end(), b, e);
+	});
+	ASSERT_TRUE(std::equal(y.begin(), y.end(), z.begin()));
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+}
+
+TEST(PackedDequeTest, ids)
+{
+	PackedDeque<std::uint64_t> x;
+	for(std::uint64_t i = 0; i != 50000; ++i)
+		x.push_back(i * 3 + 7);
+	ASSERT_LT(8 * x.storage(), x.size() * sizeof(std::uint64_t));
+	ASSERT_EQ(x.words(x.slot(10)), 1u);
+	ASSERT_EQ(x.slot(10).width, 0u);
+	ASSERT_FALSE(x.slot(10).delta);
+	for(std::uint64_t i = 0; i < 50000; i += 7)
+		ASSERT_EQ(x[i], i * 3 + 7);
+	ASSERT_EQ(x.back(), 49999u * 3 + 7);
+	ASSERT_THROW(x.at(50000), std::out_of_range);
+}
+
+TEST(PackedDequeTest, push_pop)
+{
+	PackedDeque<int> x;
+	std::deque<int> y;
+	srand(4949);
+	for(int i = 0; i != 60000; ++i)
+	{
+		int r = rand() % 10;
+		int v = rand() - RAND_MAX / 2;
+		if(r < 3)
+		{
+			x.push_back(v);
+			y.push_back(v);
+		}
+		else if(r < 6)
+		{
+			x.push_front(v);
+			y.push_front(v);
+		}
+		else if(r < 8 && !y.empty() && i < 50000)
+		{
+			x.pop_back();
+			y.pop_back();
+		}
+		else if(!y.empty() && (i < 50000 || i % 2 == 0))
+		{
+			x.pop_front();
+			y.pop_front();
+		}
+		ASSERT_EQ(x.size(), y.size());
+		if(!y.empty())
+		{
+			ASSERT_EQ(x.front(), y.front());
+			ASSERT_EQ(x.back(), y.back());
+			std::size_t j = rand() % y.size();
+			ASSERT_EQ(x[j], y[j]);
+		}
+	}
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	PackedDeque<int> z(x);
+	ASSERT_TRUE(z == x);
+	while(!y.empty())
+	{
+		ASSERT_EQ(z.back(), y.back());
+		z.pop_back();
+		y.pop_back();
+	}
+	ASSERT_TRUE(z.empty());
+	ASSERT_TRUE(z < x);
+	x.clear();
+	ASSERT_EQ(x.storage(), 0u);
+}
+
+TEST(PackedDequeTest, thaw)
+{
+	PackedDeque<short> x;
+	for(int i = 0; i != 10 * SIZET; ++i)
+		x.push_back(static_cast<short>(i % 3000 - 1500));
+	ASSERT_TRUE(x.slot(5).raw == nullptr);
+	for(int i = 10 * SIZET; i != 0; --i)
+	{
+		ASSERT_EQ(x.back(), static_cast<short>((i - 1) % 3000 - 1500));
+		x.pop_back();
+	}
+	for(int i = 0; i != 10 * SIZET; ++i)
+		x.push_front(static_cast<short>(i));
+	ASSERT_TRUE(x.slot(5).raw == nullptr);
+	for(int i = 10 * SIZET; i != 0; --i)
+	{
+		ASSERT_EQ(x.front(), static_cast<short>(i - 1));
+		x.pop_front();
+	}
+	ASSERT_TRUE(x.empty());
+}
+
+TEST(PackedDequeTest, iterator)
+{
+	PackedDeque<int> x;
+	std::deque<int> y;
+	srand(5049);
+	int v = 0;
+	for(int i = 0; i != 8 * SIZET + 123; ++i)
+	{
+		v += rand() % 100;
+		x.push_front(-v);
+		y.push_front(-v);
+	}
+	ASSERT_TRUE(x.slot(3).delta);
+	ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+	PackedDeque<int>::const_iterator i = x.end();
+	std::deque<int>::const_iterator j = y.end();
+	while(i != x.begin())
+		ASSERT_EQ(*--i, *--j);
+	for(int k = 0; k != 1000; ++k)
+	{
+		std::size_t n = 1 + rand() % (y.size() - 2);
+		i = x.begin() + n;
+		ASSERT_EQ(*i, y[n]);
+		ASSERT_EQ(*--i, y[n - 1]);
+		ASSERT_EQ(*++i, y[n]);
+		ASSERT_EQ(*++i, y[n + 1]);
+	}
+	PackedDeque<int> z(x);
+	ASSERT_TRUE(z == x);
+	z.pop_back();
+	ASSERT_FALSE(z == x);
+	ASSERT_TRUE(z < x);
+}
+
+// ----------------
+// DequeGrowthTest
+// ----------------
+
+TEST(DequeGrowthTest, factor)
+{
+	MyDeque<int> x;
+	MyDeque<int> y;
+	y.set_growth_policy(MyDeque<int>::growth_policy(1.5));
+	for(int i = 0; i != 20 * SIZET; ++i)
+	{
+		x.push_back(i);
+		y.push_back(i);
+	}
+	ASSERT_TRUE(x == y);
+	#ifdef DEQUE_STATS
+	ASSERT_GT(y.stats().rebuilds, x.stats().rebuilds);
+	#endif
+	MyDeque<int> v;
+	MyDeque<int> w(MyDeque<int>::growth_policy(1.5));
+	v.resize(10 * SIZET);
+	w.resize(10 * SIZET);
+	ASSERT_EQ(v.ce - v.cb, 21);
+	ASSERT_EQ(w.ce - w.cb, 16);
+	MyDeque<int> z(SIZET, 0, MyDeque<int>::growth_policy(1));
+	z.push_back(1);
+	ASSERT_EQ(z.ce - z.cb, 3);
+	ASSERT_THROW(z.set_growth_policy(MyDeque<int>::growth_policy(0.5)), std::invalid_argument);
+	ASSERT_THROW(MyDeque<int>(MyDeque<int>::growth_policy(0.5)), std::invalid_argument);
+	ASSERT_THROW(MyDeque<int>(SIZET, 0, MyDeque<int>::growth_policy(0.5)), std::invalid_argument);
+	ASSERT_THROW(MyDeque<int>(MyDeque<int>::growth_policy(std::numeric_limits<double>::quiet_NaN())), std::invalid_argument);
+}
+
+TEST(DequeGrowthTest, headroom)
+{
+	MyDeque<int> x(2000, 7, MyDeque<int>::growth_policy(2, 1500, 500));
+	ASSERT_EQ(x.size(), 2000u);
+	ASSERT_EQ(x.b, 500);
+	for(int i = 0; i != 1500; ++i)
+		x.push_front(-i);
+	for(int i = 0; i != 500; ++i)
+		x.push_back(i);
+	ASSERT_EQ(x.stats().rebuilds, 0u);
+	ASSERT_EQ(x.size(), 4000u);
+	ASSERT_EQ(x.front(), -1499);
+	ASSERT_EQ(x[1500], 7);
+	ASSERT_EQ(x.back(), 499);
+	MyDeque<int> y(x);
+	y.push_front(0);
+	ASSERT_EQ(y.stats().rebuilds, 0u);
+	MyDeque<int> z(MyDeque<int>::growth_policy(2, 0, 3 * SIZET));
+	ASSERT_TRUE(z.empty());
+	for(int i = 0; i != 3 * SIZET; ++i)
+		z.push_back(i);
+	ASSERT_EQ(z.stats().rebuilds, 0u);
+}
+
+TEST(DequeGrowthTest, copy_bias)
+{
+	MyDeque<int> x;
+	for(int i = 0; i != 1500; ++i)
+		x.push_front(i);
+	x.push_back(-1);
+	ASSERT_EQ(x.push_bias(), -1499);
+	MyDeque<int> y(x);
+	ASSERT_TRUE(x == y);
+	ASSERT_EQ(y.push_bias(), -1499);
+	ASSERT_EQ(y.b, 499);
+	for(int i = 0; i != 499; ++i)
+		y.push_front(i);
+	ASSERT_EQ(y.stats().rebuilds, 0u);
+	ASSERT_EQ(y.size(), 2000u);
+	ASSERT_EQ(y.front(), 498);
+	ASSERT_EQ(y.back(), -1);
+	MyDeque<int> z;
+	for(int i = 0; i != 1500; ++i)
+		z.push_back(i);
+	MyDeque<int> w(z);
+	ASSERT_EQ(w.b, 0);
+	ASSERT_EQ(w.ce - w.cb, 2);
+}
+
+TEST(DequeGrowthTest, append_keeps_policy)
+{
+	MyDeque<int> x(MyDeque<int>::growth_policy(1.5));
+	x.push_front(0);
+	MyDeque<int> y(3 * SIZET, 1);
+	y.push_back(2);
+	x.append(std::move(y));
+	ASSERT_EQ(x.size(), 3 * SIZET + 2);
+	ASSERT_EQ(x.front(), 0);
+	ASSERT_EQ(x.back(), 2);
+	ASSERT_EQ(x.growth.factor, 1.5);
+	ASSERT_EQ(x.push_bias(), -1);
+	ASSERT_TRUE(y.empty());
+	ASSERT_EQ(y.growth.factor, 2);
+	ASSERT_EQ(y.push_bias(), 1);
+	MyDeque<int> z(MyDeque<int>::growth_policy(3));
+	z.push_back(4);
+	z.prepend(std::move(x));
+	ASSERT_EQ(z.size(), 3 * SIZET + 3);
+	ASSERT_EQ(z.front(), 0);
+	ASSERT_EQ(z.back(), 4);
+	ASSERT_EQ(z.growth.factor, 3);
+	ASSERT_EQ(z.push_bias(), 1);
+	ASSERT_EQ(x.growth.factor, 1.5);
+}
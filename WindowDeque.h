@@ -0,0 +1,369 @@
+// -------------
+// WindowDeque.h
+// -------------
+
+#ifndef WindowDeque_h
+#define WindowDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>     // assert
+#include <cmath>       // abs
+#include <memory>      // allocator
+#include <type_traits> // is_floating_point
+
+#include "Deque.h" // MyDeque
+
+// ----------
+// window_sum
+// ----------
+
+///
+/// The running sum of a WindowDeque, which adds and subtracts exactly for integral types
+/// @tparam T - Type of the elements
+/// @tparam F - true if T is a floating point type
+///
+template <typename T, bool F = std::is_floating_point<T>::value>
+class window_sum
+{
+private:
+	T s;
+
+public:
+	window_sum () : s ()
+	{}
+
+	void add (const T& v)
+	{
+		s += v;
+	}
+
+	void remove (const T& v)
+	{
+		s -= v;
+	}
+
+	void reset ()
+	{
+		s = T();
+	}
+
+	T value () const
+	{
+		return s;
+	}
+};
+
+///
+/// The running sum of a WindowDeque of floating point elements, compensated with the Kahan-Babuska (Neumaier) algorithm
+/// The rounding error of each addition is accumulated in c. Plain Kahan summation loses it when a term is larger than the sum,
+/// which happens whenever a large element leaves the window.
+///
+template <typename T>
+class window_sum<T, true>
+{
+private:
+	T s;
+	T c;
+
+public:
+	window_sum () : s (), c ()
+	{}
+
+	void add (const T& v)
+	{
+		T t = s + v;
+		if(std::abs(s) >= std::abs(v))
+			c += (s - t) + v;
+		else
+			c += (v - t) + s;
+		s = t;
+	}
+
+	void remove (const T& v)
+	{
+		add(-v);
+	}
+
+	void reset ()
+	{
+		s = T();
+		c = T();
+	}
+
+	T value () const
+	{
+		return s + c;
+	}
+};
+
+// -----------
+// WindowDeque
+// -----------
+
+///
+/// A sliding window over a MyDeque that keeps its minimum, maximum and sum up to date as elements enter with push_back and
+/// leave with pop_front, so each query is O(1) instead of a scan of the window
+/// The minimum and maximum come from monotonic deques: mins holds the elements that are smaller than every later element, so
+/// its front is the minimum, and push_back drops the elements at its back that the new one makes unreachable; every element
+/// enters and leaves each of them once, so push_back and pop_front are amortized O(1). The elements are read only, since
+/// changing one would make the aggregates stale.
+/// @tparam T - Type of the elements, which are compared with <
+/// @tparam A - Type of Allocator object of the MyDeques; The default value - std::allocator
+///
+template < typename T, typename A = std::allocator<T> >
+class WindowDeque
+{
+public:
+	// --------
+	// typedefs
+	// --------
+
+	typedef MyDeque<T, A>                            container_type;
+
+	typedef typename container_type::value_type      value_type;
+	typedef typename container_type::size_type       size_type;
+	typedef typename container_type::const_reference const_reference;
+	typedef typename container_type::const_iterator  const_iterator;
+
+private:
+	// ----
+	// data
+	// ----
+
+	container_type data;
+	container_type mins; // the elements of data smaller than every later one, ascending
+	container_type maxs; // the elements of data larger than every later one, descending
+	window_sum<T> total;
+
+private:
+	// -----
+	// valid
+	// -----
+
+	///
+	/// @return true if the WindowDeque object is in a valid state
+	///
+	bool valid () const
+	{
+		return data.empty() ? (mins.empty() && maxs.empty()) : (!mins.empty() && !maxs.empty() &&
+			mins.size() <= data.size() && maxs.size() <= data.size() && !(data.back() < mins.back()) && !(mins.back() < data.back()) &&
+			!(data.back() < maxs.back()) && !(maxs.back() < data.back()));
+	}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	* Create an empty WindowDeque
+	* @param a - an optional argument for an allocator object
+	*/
+	explicit WindowDeque (const A& a = A()) : data (a), mins (a), maxs (a)
+	{
+		assert(valid());
+	}
+
+	// -----------
+	// operator []
+	// -----------
+
+	/**
+	* @param index - element position in the window
+	* @return a const reference to the element at the position in the window
+	*/
+	const_reference operator [] (size_type index) const
+	{
+		return data[index];
+	}
+
+	// ----
+	// back
+	// ----
+
+	/**
+	* @return a const reference to the newest element
+	*/
+	const_reference back () const
+	{
+		assert(!empty());
+		return data.back();
+	}
+
+	// ----
+	// base
+	// ----
+
+	/**
+	* @return the MyDeque holding the window, oldest element first
+	*/
+	const container_type& base () const
+	{
+		return data;
+	}
+
+	// -----
+	// begin
+	// -----
+
+	/**
+	* @return a Const Iterator to the oldest element
+	*/
+	const_iterator begin () const
+	{
+		return data.begin();
+	}
+
+	// -----
+	// clear
+	// -----
+
+	/**
+	* Remove every element and reset the aggregates
+	*/
+	void clear ()
+	{
+		data.clear();
+		mins.clear();
+		maxs.clear();
+		total.reset();
+		assert(valid());
+	}
+
+	// -----
+	// empty
+	// -----
+
+	/**
+	* @return true if the window is empty
+	*/
+	bool empty () const
+	{
+		return data.empty();
+	}
+
+	// ---
+	// end
+	// ---
+
+	/**
+	* @return a Const Iterator past the newest element
+	*/
+	const_iterator end () const
+	{
+		return data.end();
+	}
+
+	// -----
+	// front
+	// -----
+
+	/**
+	* @return a const reference to the oldest element
+	*/
+	const_reference front () const
+	{
+		assert(!empty());
+		return data.front();
+	}
+
+	// ---
+	// max
+	// ---
+
+	/**
+	* @return a const reference to the largest element, the oldest of them if several are equal; O(1)
+	*/
+	const_reference max () const
+	{
+		assert(!empty());
+		return maxs.front();
+	}
+
+	// ---
+	// min
+	// ---
+
+	/**
+	* @return a const reference to the smallest element, the oldest of them if several are equal; O(1)
+	*/
+	const_reference min () const
+	{
+		assert(!empty());
+		return mins.front();
+	}
+
+	// ---------
+	// pop_front
+	// ---------
+
+	/**
+	* Remove the oldest element from the window; amortized O(1)
+	*/
+	void pop_front ()
+	{
+		assert(!empty());
+		const_reference v = data.front();
+		// mins.front() is the minimum, so it is v unless v is larger; equal elements each have their own entry
+		if(!(mins.front() < v))
+			mins.pop_front();
+		if(!(v < maxs.front()))
+			maxs.pop_front();
+		total.remove(v);
+		data.pop_front();
+		// An empty window restarts the sum, discarding the rounding error left by floating point elements
+		if(data.empty())
+			total.reset();
+		assert(valid());
+	}
+
+	// ---------
+	// push_back
+	// ---------
+
+	/**
+	* Add an element to the window; amortized O(1)
+	* @param v - a const reference to the value of the new element
+	*/
+	void push_back (const_reference v)
+	{
+		data.push_back(v);
+		while(!mins.empty() && v < mins.back())
+			mins.pop_back();
+		mins.push_back(v);
+		while(!maxs.empty() && maxs.back() < v)
+			maxs.pop_back();
+		maxs.push_back(v);
+		total.add(v);
+		assert(valid());
+	}
+
+	// ----
+	// size
+	// ----
+
+	/**
+	* @return the # of elements in the window
+	*/
+	size_type size () const
+	{
+		return data.size();
+	}
+
+	// ---
+	// sum
+	// ---
+
+	/**
+	* @return the sum of the elements, compensated for rounding if T is a floating point type; O(1)
+	*/
+	value_type sum () const
+	{
+		return total.value();
+	}
+};
+
+#endif // WindowDeque_h